@@ -0,0 +1,333 @@
+//
+//  fill_bench.c
+//  host
+//
+//  Fill primitives benchmark (polyfill, texfill, alphafill, texalphafill) over polygon distributions:
+//  parameterised (far tiles, near tiles, particles, size sweep, slivers) and sampled from
+//  captured frames (-c, see raster_replay). Each primitive is timed in isolation (best of
+//  -r passes), per polygon/scanline/pixel costs are fitted over the synthetic distributions.
+//  Results are written as JSON.
+//
+//  usage: fill_bench [-n polygons] [-r passes] [-c capture]* [-o output.json]
+//
+
+#include <stdio.h>
+#include <math.h>
+#include <float.h>
+#include "pd_stub.h"
+#include "gfx.h"
+#include "realloc.h"
+#include "capture.h"
+
+#define MAX_VERTS 8
+#define MAX_DISTRIBUTIONS 32
+
+#define PRIM_POLYFILL 0
+#define PRIM_TEXFILL 1
+#define PRIM_ALPHAFILL 2
+#define PRIM_TEXALPHAFILL 3
+#define PRIMS 4
+static const char* _prim_names[PRIMS] = { "polyfill", "texfill", "alphafill", "texalphafill" };
+
+typedef struct {
+    int n;
+    Point3du pts[MAX_VERTS];
+} BenchPoly;
+
+typedef struct {
+    char name[64];
+    // sampled from real frames
+    int captured;
+    int n;
+    BenchPoly* polys;
+    // on screen scanlines & pixels
+    double spans;
+    double pixels;
+    // best pass (seconds)
+    double time[PRIMS];
+} Distribution;
+
+static Distribution _distributions[MAX_DISTRIBUTIONS];
+static int _num_distributions = 0;
+
+// xorshift (independent from lib3d generators)
+static uint32_t _state = 0x2545F491;
+static uint32_t next_u32() {
+    _state ^= _state << 13;
+    _state ^= _state >> 17;
+    _state ^= _state << 5;
+    return _state;
+}
+static float next_range(const float a, const float b) {
+    return a + (b - a) * ((next_u32() >> 8) / 16777216.f);
+}
+
+static uint32_t _dither[32];
+static uint8_t _ramp[8 * 32 * 16];
+
+static Distribution* push_distribution(const char* name, const int n) {
+    Distribution* d = &_distributions[_num_distributions++];
+    snprintf(d->name, sizeof(d->name), "%s", name);
+    d->n = n;
+    d->polys = lib3d_malloc(n * sizeof(BenchPoly));
+    return d;
+}
+
+// rotated square (game vertex order)
+static void make_quad(BenchPoly* poly, const float x, const float y, const float size) {
+    const float r = 0.7071f * size, a = next_range(0.f, 2.f * PI);
+    poly->n = 4;
+    for (int i = 0; i < 4; i++) {
+        const float ai = a - 0.5f * PI * i;
+        poly->pts[i].x = x + r * cosf(ai);
+        poly->pts[i].y = y + r * sinf(ai);
+        poly->pts[i].u = next_range(0.f, 14.f);
+    }
+}
+
+// squares of random size in [min_size, max_size], centers in [x0,x1]x[y0,y1]
+static void make_quads(const char* name, const int n, const float min_size, const float max_size, const float x0, const float y0, const float x1, const float y1) {
+    Distribution* d = push_distribution(name, n);
+    for (int i = 0; i < n; i++) {
+        make_quad(&d->polys[i], next_range(x0, x1), next_range(y0, y1), next_range(min_size, max_size));
+    }
+}
+
+// tall 1-2 pixels wide triangles (span setup bound)
+static void make_slivers(const int n) {
+    Distribution* d = push_distribution("slivers", n);
+    for (int i = 0; i < n; i++) {
+        BenchPoly* poly = &d->polys[i];
+        const float x = next_range(0.f, LCD_COLUMNS), y = next_range(0.f, LCD_ROWS - 120.f), w = next_range(1.f, 2.f);
+        poly->n = 3;
+        poly->pts[0] = (Point3du){ .x = x, .y = y, .u = 2.f };
+        poly->pts[1] = (Point3du){ .x = x + 4.f, .y = y + 120.f, .u = 8.f };
+        poly->pts[2] = (Point3du){ .x = x + 4.f + w, .y = y + 120.f, .u = 12.f };
+    }
+}
+
+// polygons of a captured fill type
+static void load_capture(const char* path, const CaptureReplay* replay, const int type) {
+    int n = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        Distribution* d = NULL;
+        if (pass == 1) {
+            if (n == 0 || _num_distributions == MAX_DISTRIBUTIONS) return;
+            char name[64];
+            const char* file = strrchr(path, '/');
+            snprintf(name, sizeof(name), "%s:%s", file ? file + 1 : path, _prim_names[type - CAPTURE_POLYFILL]);
+            d = push_distribution(name, n);
+            d->captured = 1;
+            n = 0;
+        }
+        for (int k = 0; k < replay->header.frames; k++) {
+            const CaptureFrame* frame = (const CaptureFrame*)replay->frames[k];
+            const uint8_t* p = replay->frames[k] + sizeof(CaptureFrame) + LCD_ROWSIZE * LCD_ROWS;
+            for (int i = 0; i < frame->n; i++) {
+                const CaptureCommand* cmd = (const CaptureCommand*)p;
+                if (cmd->type == type && cmd->n <= MAX_VERTS) {
+                    if (d) {
+                        d->polys[n].n = cmd->n;
+                        memcpy(d->polys[n].pts, p + sizeof(CaptureCommand), cmd->n * sizeof(Point3du));
+                    }
+                    n++;
+                }
+                p += sizeof(CaptureCommand) + cmd->n * sizeof(Point3du);
+            }
+        }
+    }
+}
+
+static uint8_t* read_file(const char* path, int* size) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    *size = (int)ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* data = lib3d_malloc(*size);
+    if (fread(data, 1, *size, f) != (size_t)*size) {
+        lib3d_free(data);
+        data = NULL;
+    }
+    fclose(f);
+    return data;
+}
+
+static int count_bits(uint32_t v) {
+    int n = 0;
+    for (; v; v &= v - 1) n++;
+    return n;
+}
+
+// scanlines (same rule as rasterizers) & pixels covered by each polygon
+static void measure(Distribution* d, uint8_t* bitmap) {
+    uint32_t solid[32];
+    memset(solid, 0xff, sizeof(solid));
+    d->spans = d->pixels = 0;
+    for (int i = 0; i < d->n; i++) {
+        const BenchPoly* poly = &d->polys[i];
+        float miny = FLT_MAX, maxy = -FLT_MAX;
+        for (int k = 0; k < poly->n; k++) {
+            if (poly->pts[k].y < miny) miny = poly->pts[k].y;
+            if (poly->pts[k].y > maxy) maxy = poly->pts[k].y;
+        }
+        if (miny > LCD_ROWS || maxy < 0.f) continue;
+        int ystart = (int)ceilf(miny), yend = (int)ceilf(maxy);
+        if (ystart < 0) ystart = 0;
+        if (yend > LCD_ROWS) yend = LCD_ROWS;
+        if (yend <= ystart) continue;
+        d->spans += yend - ystart;
+
+        memset(bitmap + ystart * LCD_ROWSIZE, 0, (yend - ystart) * LCD_ROWSIZE);
+        polyfill(poly->pts, poly->n, solid, (uint32_t*)bitmap);
+        for (int j = ystart * LCD_ROWSIZE; j < yend * LCD_ROWSIZE; j++) d->pixels += count_bits(bitmap[j]);
+    }
+}
+
+static void draw(const Distribution* d, const int prim, uint8_t* bitmap) {
+    const BenchPoly* polys = d->polys;
+    switch (prim) {
+    case PRIM_POLYFILL:
+        for (int i = 0; i < d->n; i++) polyfill(polys[i].pts, polys[i].n, _dither, (uint32_t*)bitmap);
+        break;
+    case PRIM_TEXFILL:
+        for (int i = 0; i < d->n; i++) texfill(polys[i].pts, polys[i].n, _ramp, bitmap);
+        break;
+    case PRIM_ALPHAFILL:
+        for (int i = 0; i < d->n; i++) alphafill(polys[i].pts, polys[i].n, (i & 1) ? 0xffffffff : 0, _dither, (uint32_t*)bitmap);
+        break;
+    case PRIM_TEXALPHAFILL:
+        for (int i = 0; i < d->n; i++) texalphafill(polys[i].pts, polys[i].n, _ramp, _dither, bitmap);
+        break;
+    }
+}
+
+// least squares fit of time = setup * polygons + span * spans + pixel * pixels (synthetic distributions)
+static int fit(const int prim, double* coefs) {
+    double a[3][4] = { 0 };
+    for (int k = 0; k < _num_distributions; k++) {
+        const Distribution* d = &_distributions[k];
+        if (d->captured) continue;
+        // relative error (distributions have very different totals)
+        const double w = 1.0 / d->time[prim];
+        const double x[3] = { d->n * w, d->spans * w, d->pixels * w };
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) a[i][j] += x[i] * x[j];
+            a[i][3] += x[i] * d->time[prim] * w;
+        }
+    }
+    // gaussian elimination
+    for (int i = 0; i < 3; i++) {
+        int p = i;
+        for (int j = i + 1; j < 3; j++) if (fabs(a[j][i]) > fabs(a[p][i])) p = j;
+        for (int j = 0; j < 4; j++) {
+            const double t = a[i][j]; a[i][j] = a[p][j]; a[p][j] = t;
+        }
+        if (fabs(a[i][i]) < 1e-30) return 0;
+        for (int j = 0; j < 3; j++) {
+            if (j == i) continue;
+            const double f = a[j][i] / a[i][i];
+            for (int c = i; c < 4; c++) a[j][c] -= f * a[i][c];
+        }
+    }
+    for (int i = 0; i < 3; i++) coefs[i] = a[i][3] / a[i][i];
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    int n = 10000;
+    int passes = 20;
+    const char* output = NULL;
+    const char* captures[MAX_DISTRIBUTIONS];
+    int num_captures = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) n = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-r") && i + 1 < argc) passes = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) output = argv[++i];
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc && num_captures < MAX_DISTRIBUTIONS) captures[num_captures++] = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [-n polygons] [-r passes] [-c capture]* [-o output.json]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (n < 1) n = 1;
+    if (passes < 1) passes = 1;
+
+    PlaydateAPI* pd = pd_stub_init();
+    lib3d_setRealloc(pd->system->realloc);
+    gfx_init(pd);
+    capture_init(pd);
+    for (int i = 0; i < 32; i++) _dither[i] = next_u32();
+    // game layout: 8 bytes per shade, 4 columns repeated twice
+    for (int i = 0; i < (int)sizeof(_ramp); i++) _ramp[i] = (i & 4) ? _ramp[i - 4] : (uint8_t)next_u32();
+
+    // game like distributions
+    make_quads("far_tiles", n, 2.f, 8.f, 0.f, 40.f, LCD_COLUMNS, 120.f);
+    make_quads("near_tiles", max(1, n / 100), 100.f, 500.f, -100.f, 100.f, LCD_COLUMNS + 100.f, LCD_ROWS + 100.f);
+    make_quads("particles", n, 4.f, 24.f, 0.f, 0.f, LCD_COLUMNS, LCD_ROWS);
+    make_slivers(n);
+    // size sweep
+    for (int size = 1; size <= 256; size *= 2) {
+        char name[64];
+        snprintf(name, sizeof(name), "quads_%i", size);
+        make_quads(name, max(1, n * 4 / (size + 4)), size, size, 0.f, 0.f, LCD_COLUMNS, LCD_ROWS);
+    }
+    // real frames
+    for (int i = 0; i < num_captures; i++) {
+        int size;
+        uint8_t* data = read_file(captures[i], &size);
+        CaptureReplay replay;
+        if (!data || !capture_open(&replay, data, size)) {
+            fprintf(stderr, "invalid capture: %s\n", captures[i]);
+            return 1;
+        }
+        for (int type = CAPTURE_POLYFILL; type <= CAPTURE_ALPHAFILL; type++) load_capture(captures[i], &replay, type);
+        capture_close(&replay);
+        lib3d_free(data);
+    }
+
+    uint8_t* bitmap = pd_stub_frame();
+    for (int k = 0; k < _num_distributions; k++) {
+        Distribution* d = &_distributions[k];
+        measure(d, bitmap);
+        for (int prim = 0; prim < PRIMS; prim++) {
+            double best = DBL_MAX;
+            for (int r = 0; r < passes; r++) {
+                const double t0 = pd_stub_time();
+                draw(d, prim, bitmap);
+                const double t = pd_stub_time() - t0;
+                if (t < best) best = t;
+            }
+            d->time[prim] = best;
+        }
+    }
+
+    FILE* f = output ? fopen(output, "w") : stdout;
+    if (!f) {
+        fprintf(stderr, "unable to create: %s\n", output);
+        return 1;
+    }
+    fprintf(f, "{\n  \"passes\": %i,\n  \"distributions\": [\n", passes);
+    for (int k = 0; k < _num_distributions; k++) {
+        const Distribution* d = &_distributions[k];
+        fprintf(f, "    {\"name\": \"%s\", \"captured\": %s, \"polygons\": %i, \"spans\": %.0f, \"pixels\": %.0f,\n", d->name, d->captured ? "true" : "false", d->n, d->spans, d->pixels);
+        for (int prim = 0; prim < PRIMS; prim++) {
+            const double ns = 1e9 * d->time[prim];
+            fprintf(f, "      \"%s\": {\"ms\": %.4f, \"ns_per_polygon\": %.2f, \"ns_per_span\": %.3f, \"ns_per_pixel\": %.4f}%s\n",
+                _prim_names[prim], ns * 1e-6, ns / d->n, d->spans > 0 ? ns / d->spans : 0.0, d->pixels > 0 ? ns / d->pixels : 0.0, prim < PRIMS - 1 ? "," : "");
+        }
+        fprintf(f, "    }%s\n", k < _num_distributions - 1 ? "," : "");
+    }
+    fprintf(f, "  ],\n  \"fit\": {\n");
+    for (int prim = 0; prim < PRIMS; prim++) {
+        double coefs[3] = { 0 };
+        fit(prim, coefs);
+        fprintf(f, "    \"%s\": {\"ns_polygon_setup\": %.2f, \"ns_per_span\": %.3f, \"ns_per_pixel\": %.4f}%s\n",
+            _prim_names[prim], 1e9 * coefs[0], 1e9 * coefs[1], 1e9 * coefs[2], prim < PRIMS - 1 ? "," : "");
+    }
+    fprintf(f, "  }\n}\n");
+    if (output) fclose(f);
+
+    for (int k = 0; k < _num_distributions; k++) lib3d_free(_distributions[k].polys);
+    return 0;
+}
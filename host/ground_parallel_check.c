@@ -0,0 +1,155 @@
+//
+//  ground_parallel_check.c
+//  host
+//
+//  Generates many courses on all cores (one GroundContext per thread) and
+//  checks every course against a single-threaded generation of the same
+//  seed: ground snapshots + ground queries must match bit for bit.
+//
+//  usage: ground_parallel_check [-n seeds] [-t threads] [-k slices]
+//
+
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "pd_stub.h"
+#include "ground.h"
+#include "bench.h"
+
+typedef struct {
+    GroundContext* ground;
+    GroundState* state;
+    TrackPatterns* patterns;
+} Generator;
+
+static void make_generator(Generator* gen) {
+    gen->ground = create_ground_context();
+    gen->state = malloc(get_ground_state_size());
+    gen->patterns = malloc(sizeof(TrackPatterns));
+}
+
+static void free_generator(Generator* gen) {
+    destroy_ground_context(gen->ground);
+    free(gen->state);
+    free(gen->patterns);
+}
+
+// generates seed and moves down the course for the given number of slices
+static uint64_t run_seed(Generator* gen, const int seed, const int slices) {
+    GroundParams params;
+    get_bench_params(seed, seed % 3, &params);
+    make_ground(gen->ground, params, gen->patterns);
+
+    Point3d pos;
+    get_start_pos(gen->ground, &pos);
+    uint64_t h = PD_STUB_HASH_SEED;
+    for (int k = 0; k < slices; k++) {
+        pos.z += GROUND_CELL_SIZE;
+        int slice_id;
+        TrackPattern pattern;
+        Point3d offset;
+        update_ground(gen->ground, pos, &slice_id, &pattern, &offset);
+        for (int i = 0; i < 3; i++) pos.v[i] += offset.v[i];
+
+        Point3d n;
+        float y;
+        if (get_face(gen->ground, pos, &n, &y)) {
+            pos.y = y;
+            h = pd_stub_hash_bytes(h, &n, sizeof(n));
+        }
+        int hit_type;
+        collide(gen->ground, pos, 0.5f, &hit_type);
+        h = pd_stub_hash_bytes(h, &slice_id, sizeof(slice_id));
+        h = pd_stub_hash_bytes(h, &pattern, sizeof(pattern));
+        h = pd_stub_hash_bytes(h, &pos, sizeof(pos));
+        h = pd_stub_hash_bytes(h, &hit_type, sizeof(hit_type));
+    }
+    save_ground_state(gen->ground, gen->state);
+    return pd_stub_hash_bytes(h, gen->state, get_ground_state_size());
+}
+
+typedef struct {
+    pthread_t thread;
+    int first;
+    int step;
+    int seeds;
+    int slices;
+    uint64_t* hashes;
+} Worker;
+
+static void* run_worker(void* arg) {
+    Worker* worker = (Worker*)arg;
+    Generator gen;
+    make_generator(&gen);
+    for (int i = worker->first; i < worker->seeds; i += worker->step) {
+        worker->hashes[i] = run_seed(&gen, i + 1, worker->slices);
+    }
+    free_generator(&gen);
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    int seeds = 10000;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int slices = 64;
+    if (threads < 4) threads = 4;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) seeds = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-k") && i + 1 < argc) slices = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [-n seeds] [-t threads] [-k slices]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (seeds < 1) seeds = 1;
+    if (threads < 1) threads = 1;
+
+    pd_stub_init_lib3d(-1);
+
+    uint64_t* ref = malloc(seeds * sizeof(uint64_t));
+    uint64_t* hashes = malloc(seeds * sizeof(uint64_t));
+
+    // reference
+    double t0 = pd_stub_time();
+    Generator gen;
+    make_generator(&gen);
+    for (int i = 0; i < seeds; i++) {
+        ref[i] = run_seed(&gen, i + 1, slices);
+    }
+    free_generator(&gen);
+    const double single_time = pd_stub_time() - t0;
+
+    // one context per thread (interleaved seeds)
+    Worker* workers = malloc(threads * sizeof(Worker));
+    t0 = pd_stub_time();
+    for (int i = 0; i < threads; i++) {
+        workers[i] = (Worker){ .first = i, .step = threads, .seeds = seeds, .slices = slices, .hashes = hashes };
+        if (pthread_create(&workers[i].thread, NULL, run_worker, &workers[i])) {
+            fprintf(stderr, "unable to start thread: %i\n", i);
+            return 1;
+        }
+    }
+    for (int i = 0; i < threads; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+    const double parallel_time = pd_stub_time() - t0;
+
+    int mismatches = 0, first = -1;
+    for (int i = 0; i < seeds; i++) {
+        if (hashes[i] != ref[i]) {
+            if (first < 0) first = i + 1;
+            mismatches++;
+        }
+    }
+
+    printf("seeds: %i slices: %i threads: %i mismatches: %i", seeds, slices, threads, mismatches);
+    if (first >= 0) printf(" (first seed: %i)", first);
+    printf("\n");
+    printf("single: %.3fs parallel: %.3fs (%.2fx)\n", single_time, parallel_time, single_time / parallel_time);
+
+    free(workers);
+    free(hashes);
+    free(ref);
+    return mismatches > 0;
+}
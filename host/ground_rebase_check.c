@@ -0,0 +1,136 @@
+//
+//  ground_rebase_check.c
+//  host
+//
+//  Records rendered frames + ground queries (get_face, collide, update_ground
+//  offsets) along the benchmark flight, with regular multi-tile jumps.
+//  Built twice: against the ring buffer ground (ground_rebase_check) and
+//  against the legacy shifting ground (ground_rebase_check_eager, built with
+//  GROUND_EAGER_REBASE). Traces must match bit for bit, whatever the slice
+//  generation budget:
+//
+//    ground_rebase_check_eager -w eager.trace
+//    ground_rebase_check -c eager.trace
+//
+//  usage: ground_rebase_check [-n frames] [-s seed] [-b generation budget us] [-w trace | -c trace]
+//
+
+#include <stdio.h>
+#include "pd_stub.h"
+#include "ground.h"
+#include "bench.h"
+
+// per frame record
+typedef struct {
+    uint64_t frame_hash;
+    uint64_t query_hash;
+} FrameTrace;
+
+static uint64_t hash_queries(GroundContext* ground, const Point3d pos, const Point3d offset) {
+    uint64_t h = pd_stub_hash_bytes(PD_STUB_HASH_SEED, &offset, sizeof(offset));
+    // ground around player
+    for (int j = -8; j <= 8; j++) {
+        for (int i = -8; i <= 8; i++) {
+            const Point3d p = { .v = { pos.x + 1.3f * i, pos.y, pos.z + 1.7f * j } };
+            Point3d n;
+            float y;
+            if (get_face(ground, p, &n, &y)) {
+                h = pd_stub_hash_bytes(h, &n, sizeof(n));
+                h = pd_stub_hash_bytes(h, &y, sizeof(y));
+            }
+        }
+    }
+    // props
+    int hit_type;
+    collide(ground, pos, 0.5f, &hit_type);
+    return pd_stub_hash_bytes(h, &hit_type, sizeof(hit_type));
+}
+
+int main(int argc, char** argv) {
+    int frames = 3000;
+    int seed = BENCH_SEED;
+    int budget = -1;
+    const char* write_path = NULL;
+    const char* check_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) frames = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc) seed = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-b") && i + 1 < argc) budget = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-w") && i + 1 < argc) write_path = argv[++i];
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc) check_path = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [-n frames] [-s seed] [-b generation budget us] [-w trace | -c trace]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (frames < 1) frames = 1;
+
+    PlaydateAPI* pd = pd_stub_init_lib3d(budget);
+
+    GroundParams params;
+    get_bench_params(seed, 0, &params);
+    TrackPatterns* patterns = malloc(sizeof(TrackPatterns));
+    GroundContext* ground = create_ground_context();
+    make_ground(ground, params, patterns);
+
+    FrameTrace* trace = malloc(frames * sizeof(FrameTrace));
+    BenchFlight flight;
+    start_bench_flight(ground, &flight);
+    uint8_t* bitmap = pd->graphics->getFrame();
+    for (int k = 0; k < frames; k++) {
+        // multi-tile moves
+        if (k % 50 == 49) flight.pos.z += 3.5f * GROUND_CELL_SIZE;
+
+        Point3d cam_pos;
+        float cam_tau_angle;
+        Mat4 m;
+        const Point3d prev_pos = flight.pos;
+        update_bench_flight(ground, &flight, &cam_pos, &cam_tau_angle, m);
+        render_ground(ground, cam_pos, cam_tau_angle, m, 0, bitmap);
+
+        // world offset applied by update_ground
+        const Point3d offset = { .v = { 0.f, flight.pos.y - prev_pos.y, flight.pos.z - prev_pos.z } };
+        trace[k].frame_hash = pd_stub_hash_bytes(PD_STUB_HASH_SEED, bitmap, LCD_ROWSIZE * LCD_ROWS);
+        trace[k].query_hash = hash_queries(ground, flight.pos, offset);
+    }
+
+    int failed = 0;
+    if (write_path) {
+        FILE* f = fopen(write_path, "wb");
+        if (!f || fwrite(trace, sizeof(FrameTrace), frames, f) != (size_t)frames) {
+            fprintf(stderr, "unable to write: %s\n", write_path);
+            failed = 1;
+        }
+        if (f) fclose(f);
+        printf("frames: %i written to: %s\n", frames, write_path);
+    }
+    if (check_path) {
+        FrameTrace* ref = malloc(frames * sizeof(FrameTrace));
+        FILE* f = fopen(check_path, "rb");
+        if (!f || fread(ref, sizeof(FrameTrace), frames, f) != (size_t)frames) {
+            fprintf(stderr, "unable to read %i frames from: %s\n", frames, check_path);
+            failed = 1;
+        }
+        else {
+            int frame_diffs = 0, query_diffs = 0, first = -1;
+            for (int k = 0; k < frames; k++) {
+                const int frame_diff = trace[k].frame_hash != ref[k].frame_hash;
+                const int query_diff = trace[k].query_hash != ref[k].query_hash;
+                frame_diffs += frame_diff;
+                query_diffs += query_diff;
+                if ((frame_diff || query_diff) && first < 0) first = k;
+            }
+            printf("frames: %i render mismatches: %i query mismatches: %i", frames, frame_diffs, query_diffs);
+            if (first >= 0) printf(" (first: %i)", first);
+            printf("\n");
+            failed = frame_diffs || query_diffs;
+        }
+        if (f) fclose(f);
+        free(ref);
+    }
+
+    free(trace);
+    free(patterns);
+    destroy_ground_context(ground);
+    return failed;
+}
@@ -0,0 +1,133 @@
+//
+//  ground_state_check.c
+//  host
+//
+//  Saves the ground state at regular checkpoints along the benchmark flight,
+//  records the next frames, restores the snapshot and replays the same
+//  frames. Rendered frames + ground queries must match bit for bit, and an
+//  invalid snapshot must be rejected.
+//
+//  usage: ground_state_check [-n frames] [-s seed] [-b generation budget us] [-p checkpoint period]
+//
+
+#include <stdio.h>
+#include "pd_stub.h"
+#include "ground.h"
+#include "bench.h"
+
+// frames replayed after each checkpoint
+#define REPLAY_FRAMES 200
+
+// render + query ground around flight
+static uint64_t run_frame(GroundContext* ground, BenchFlight* flight, uint8_t* bitmap) {
+    const int k = flight->frame;
+    // multi-tile moves
+    if (k % 50 == 49) flight->pos.z += 3.5f * GROUND_CELL_SIZE;
+
+    Point3d cam_pos;
+    float cam_tau_angle;
+    Mat4 m;
+    update_bench_flight(ground, flight, &cam_pos, &cam_tau_angle, m);
+    render_ground(ground, cam_pos, cam_tau_angle, m, 0, bitmap);
+
+    uint64_t h = pd_stub_hash_bytes(PD_STUB_HASH_SEED, bitmap, LCD_ROWSIZE * LCD_ROWS);
+    h = pd_stub_hash_bytes(h, &flight->pos, sizeof(Point3d));
+    for (int j = -8; j <= 8; j++) {
+        for (int i = -8; i <= 8; i++) {
+            const Point3d p = { .v = { flight->pos.x + 1.3f * i, flight->pos.y, flight->pos.z + 1.7f * j } };
+            Point3d n;
+            float y;
+            if (get_face(ground, p, &n, &y)) {
+                h = pd_stub_hash_bytes(h, &n, sizeof(n));
+                h = pd_stub_hash_bytes(h, &y, sizeof(y));
+            }
+        }
+    }
+    int hit_type;
+    collide(ground, flight->pos, 0.5f, &hit_type);
+    return pd_stub_hash_bytes(h, &hit_type, sizeof(hit_type));
+}
+
+int main(int argc, char** argv) {
+    int frames = 3000;
+    int seed = BENCH_SEED;
+    int budget = -1;
+    int period = 500;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) frames = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc) seed = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-b") && i + 1 < argc) budget = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-p") && i + 1 < argc) period = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [-n frames] [-s seed] [-b generation budget us] [-p checkpoint period]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (period < REPLAY_FRAMES + 1) period = REPLAY_FRAMES + 1;
+
+    PlaydateAPI* pd = pd_stub_init_lib3d(budget);
+
+    GroundParams params;
+    get_bench_params(seed, 0, &params);
+    TrackPatterns* patterns = malloc(sizeof(TrackPatterns));
+    GroundContext* ground = create_ground_context();
+    make_ground(ground, params, patterns);
+
+    GroundState* state = malloc(get_ground_state_size());
+    TrackPatterns* saved_patterns = malloc(sizeof(TrackPatterns));
+    uint64_t ref[REPLAY_FRAMES];
+    BenchFlight flight, saved_flight;
+    start_bench_flight(ground, &flight);
+    uint8_t* bitmap = pd->graphics->getFrame();
+
+    int checkpoints = 0, mismatches = 0, first = -1;
+    double restore_time = 0, max_restore_time = 0;
+    while (flight.frame < frames) {
+        if (flight.frame % period == 0 && flight.frame > 0) {
+            // checkpoint
+            save_ground_state(ground, state);
+            saved_flight = flight;
+            // note: track patterns are reported by make_ground (e.g. visible slices)
+            memcpy(saved_patterns, patterns, sizeof(TrackPatterns));
+            for (int k = 0; k < REPLAY_FRAMES; k++) {
+                ref[k] = run_frame(ground, &flight, bitmap);
+            }
+
+            // restart from checkpoint
+            const double t0 = pd_stub_time();
+            if (!restore_ground_state(ground, state, patterns)) return 1;
+            const double t = pd_stub_time() - t0;
+            restore_time += t;
+            if (t > max_restore_time) max_restore_time = t;
+
+            flight = saved_flight;
+            for (int k = 0; k < REPLAY_FRAMES; k++) {
+                if (run_frame(ground, &flight, bitmap) != ref[k]) {
+                    if (first < 0) first = flight.frame - 1;
+                    mismatches++;
+                }
+            }
+            checkpoints++;
+        }
+        run_frame(ground, &flight, bitmap);
+    }
+
+    // invalid snapshot (version is the first field) must be rejected without halting
+    int rejected = 0;
+    if (checkpoints) {
+        ((int*)state)[0] = -1;
+        rejected = !restore_ground_state(ground, state, patterns);
+    }
+
+    printf("state: %i bytes checkpoints: %i replayed frames: %i mismatches: %i", get_ground_state_size(), checkpoints, checkpoints * REPLAY_FRAMES, mismatches);
+    if (first >= 0) printf(" (first: %i)", first);
+    printf("\n");
+    if (checkpoints) printf("invalid snapshot: %s\n", rejected ? "rejected" : "accepted");
+    if (checkpoints) printf("restore avg: %.3fms max: %.3fms\n", 1000.0 * restore_time / checkpoints, 1000.0 * max_restore_time);
+
+    free(saved_patterns);
+    free(state);
+    free(patterns);
+    destroy_ground_context(ground);
+    return mismatches > 0 || (checkpoints && !rejected);
+}
@@ -0,0 +1,183 @@
+//
+//  input_replay.c
+//  host
+//
+//  Render benchmark driven by a player input recording: inputs are fed
+//  through the player simulation (update_ground, collide) and every frame
+//  is rendered from the player camera (render_ground).
+//
+//  -o: records a run (track following autopilot) instead
+//  -c: captures raster commands of frames [-a, -a + -k[ (see raster_replay)
+//
+//  usage: input_replay [-i recording] [-n repeat] [-r render flags] [-c capture [-a first frame] [-k frames]]
+//         input_replay -o recording [-s seed | -d yyyy/mm/dd] [-m mode] [-g frames]
+//
+
+#include <stdio.h>
+#include <float.h>
+#include "pd_stub.h"
+#include "realloc.h"
+#include "ground.h"
+#include "rand_r.h"
+#include "sim.h"
+#include "sim_modes.h"
+#include "record.h"
+#include "capture.h"
+
+// xorshift (independent from lib3d generators)
+static uint32_t _state = 0x12345678;
+static float next_float() {
+    _state ^= _state << 13;
+    _state ^= _state >> 17;
+    _state ^= _state << 5;
+    return (_state >> 8) / 16777216.f;
+}
+
+// steer toward track ahead (same as lua npc) + random jumps
+static int record_run(const SimMode* mode, const int frames, const char* path) {
+    GroundContext* ground = create_ground_context();
+    TrackPatterns* patterns = malloc(sizeof(TrackPatterns));
+    make_ground(ground, mode->ground, patterns);
+
+    InputRecorder recorder = { 0 };
+    record_start(&recorder, &mode->ground, &mode->sim);
+    SimPlayer plyr;
+    sim_start(ground, &mode->sim, &plyr);
+    int buttons = 0;
+    while (plyr.frame < frames && !plyr.dead) {
+        float xmin, xmax, z, angle;
+        int checkpoint;
+        get_track_info(ground, plyr.body.pos, &xmin, &xmax, &z, &checkpoint, &angle);
+        const float crank = 8.f * (angle + plyr.body.angle) + 2.f * (next_float() - 0.5f);
+        // hold action button for a few frames
+        if (next_float() < 0.02f) buttons = RECORD_BUTTON_ACTION;
+        else if (next_float() < 0.2f) buttons = 0;
+
+        // note: jump on press
+        const int pressed = buttons & ~recorder.prev_buttons;
+        const SimInput input = {
+            .crank = record_input(&recorder, crank, buttons),
+            .buttons = pressed ? SIM_BUTTON_JUMP : 0 };
+        sim_step(ground, &plyr, &input);
+    }
+    record_stop(&recorder);
+
+    const int res = record_save(&recorder, path);
+    if (res) {
+        printf("recorded: %i frames %i bytes (%.2f bytes/frame) to: %s\n", recorder.header.frames, recorder.size, (float)recorder.size / recorder.header.frames, path);
+        printf("distance: %i coins: %i tricks: %i%s\n", (int)plyr.distance, plyr.coins, plyr.tricks, plyr.dead ? " (dead)" : "");
+    }
+    record_free(&recorder);
+    free(patterns);
+    destroy_ground_context(ground);
+    return res;
+}
+
+typedef struct {
+    double total;
+    double min;
+    double max;
+} Timing;
+
+static void add_timing(Timing* timing, const double t) {
+    timing->total += t;
+    if (t < timing->min) timing->min = t;
+    if (t > timing->max) timing->max = t;
+}
+
+int main(int argc, char** argv) {
+    int seed = 0;
+    int mode = 1;
+    int frames = 3000;
+    int repeat = 1;
+    const char* input_path = NULL;
+    const char* output_path = NULL;
+    const char* capture_path = NULL;
+    int capture_start = 300;
+    int capture_count = 30;
+    int render_flags = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-i") && i + 1 < argc) input_path = argv[++i];
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) output_path = argv[++i];
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc) repeat = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc) seed = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-d") && i + 1 < argc) seed = (int)dek_hash(argv[++i]);
+        else if (!strcmp(argv[i], "-m") && i + 1 < argc) mode = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-g") && i + 1 < argc) frames = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-r") && i + 1 < argc) render_flags = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc) capture_path = argv[++i];
+        else if (!strcmp(argv[i], "-a") && i + 1 < argc) capture_start = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-k") && i + 1 < argc) capture_count = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [-i recording] [-n repeat] [-r render flags] [-c capture [-a first frame] [-k frames]]\n", argv[0]);
+            fprintf(stderr, "       %s -o recording [-s seed | -d yyyy/mm/dd] [-m mode] [-g frames]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (!input_path && !output_path) input_path = "replay.mwr";
+    if (mode < 0 || mode >= SIM_MODES) {
+        fprintf(stderr, "invalid mode: %i (0-%i)\n", mode, SIM_MODES - 1);
+        return 1;
+    }
+    if (repeat < 1) repeat = 1;
+
+    PlaydateAPI* pd = pd_stub_init_lib3d(-1);
+    set_render_flags(render_flags);
+
+    if (output_path) {
+        SimMode sim_mode = _sim_modes[mode];
+        sim_mode.ground.r_seed = seed;
+        return !record_run(&sim_mode, frames, output_path);
+    }
+
+    int size;
+    uint8_t* data = record_load(input_path, &size);
+    InputReplay replay;
+    if (!data || !replay_start(&replay, data, size)) {
+        fprintf(stderr, "invalid recording: %s\n", input_path);
+        return 1;
+    }
+
+    GroundContext* ground = create_ground_context();
+    TrackPatterns* patterns = malloc(sizeof(TrackPatterns));
+    uint8_t* bitmap = pd->graphics->getFrame();
+    uint64_t ref_hash = 0;
+    int failed = 0;
+    for (int r = 0; r < repeat; r++) {
+        replay_start(&replay, data, size);
+        make_ground(ground, replay.header.ground, patterns);
+        SimPlayer plyr;
+        SimCamera cam;
+        sim_start(ground, &replay.header.sim, &plyr);
+        sim_start_camera(&cam);
+
+        Timing update = { .min = DBL_MAX }, render = { .min = DBL_MAX };
+        uint64_t h = PD_STUB_HASH_SEED;
+        SimInput input;
+        while (!plyr.dead && replay_next(&replay, &input)) {
+            const double t0 = pd_stub_time();
+            sim_step(ground, &plyr, &input);
+            sim_update_camera(&plyr, &cam);
+            if (capture_path && r == 0 && plyr.frame == capture_start + 1) capture_frames(capture_path, capture_count > 0 ? capture_count : 1);
+            const double t1 = pd_stub_time();
+            render_ground(ground, cam.pos, fmodf(cam.angle, 1.f), cam.m, 0, bitmap);
+            const double t2 = pd_stub_time();
+            add_timing(&update, t1 - t0);
+            add_timing(&render, t2 - t1);
+            h = pd_stub_hash_bytes(h, bitmap, LCD_ROWSIZE * LCD_ROWS);
+        }
+
+        const int n = plyr.frame > 0 ? plyr.frame : 1;
+        printf("run %i: frames: %i distance: %i coins: %i tricks: %i hash: %016llx\n", r, plyr.frame, (int)plyr.distance, plyr.coins, plyr.tricks, (unsigned long long)h);
+        printf("  update avg: %.3fms min: %.3fms max: %.3fms\n", 1000.0 * update.total / n, 1000.0 * update.min, 1000.0 * update.max);
+        printf("  render avg: %.3fms min: %.3fms max: %.3fms\n", 1000.0 * render.total / n, 1000.0 * render.min, 1000.0 * render.max);
+        if (r == 0) ref_hash = h;
+        else if (h != ref_hash) failed = 1;
+    }
+    if (failed) fprintf(stderr, "replays are not deterministic\n");
+
+    free(patterns);
+    lib3d_free(data);
+    destroy_ground_context(ground);
+    return failed;
+}
@@ -0,0 +1,155 @@
+//
+//  lib3d_bench.c
+//  host
+//
+//  Runs make_ground + N frames of update_ground/render_ground along the
+//  lib3d benchmark camera flight (bench.c) and reports ms/frame & percentiles
+//  and the frame arena high water mark.
+//
+//  usage: lib3d_bench [-n frames] [-s seed] [-t track type] [-r render flags] [-b generation budget us] [-o last_frame.pbm]
+//
+
+#include <stdio.h>
+#include "pd_stub.h"
+#include "luaglue.h"
+#include "ground.h"
+#include "bench.h"
+#include "profile.h"
+#include "arena.h"
+
+static int cmp_float(const void* a, const void* b) {
+    const float x = *(const float*)a, y = *(const float*)b;
+    return x < y ? -1 : x > y;
+}
+
+static float percentile(const float* sorted, const int n, const float p) {
+    int i = (int)(p * (n - 1) + 0.5f);
+    return sorted[i];
+}
+
+int main(int argc, char** argv) {
+    int frames = 600;
+    int seed = BENCH_SEED;
+    int budget = -1;
+    int track_type = 0;
+    int render_flags = 0;
+    const char* pbm = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) frames = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc) seed = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-b") && i + 1 < argc) budget = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) track_type = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-r") && i + 1 < argc) render_flags = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) pbm = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [-n frames] [-s seed] [-t track type] [-r render flags] [-b generation budget us] [-o last_frame.pbm]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (frames < 1) frames = 1;
+
+    PlaydateAPI* pd = pd_stub_init();
+    lib3d_register(pd);
+    if (budget >= 0) set_generation_budget(budget);
+    set_render_flags(render_flags);
+    while (ground_load_assets_async());
+
+    GroundParams params;
+    get_bench_params(seed, track_type, &params);
+    TrackPatterns* patterns = malloc(sizeof(TrackPatterns));
+    GroundContext* ground = create_ground_context();
+
+    double t0 = pd_stub_time();
+    make_ground(ground, params, patterns);
+    const double make_ms = (pd_stub_time() - t0) * 1000.0;
+
+    BenchFlight flight;
+    start_bench_flight(ground, &flight);
+
+    float* update_times = malloc(frames * sizeof(float));
+    float* render_times = malloc(frames * sizeof(float));
+    float* frame_times = malloc(frames * sizeof(float));
+#ifdef LIB3D_PROFILE
+    FrameStatsSummary profile_total = { 0 };
+#endif
+    uint8_t* bitmap = pd->graphics->getFrame();
+    for (int k = 0; k < frames; k++) {
+        Point3d cam_pos;
+        float cam_tau_angle;
+        Mat4 m;
+        t0 = pd_stub_time();
+        update_bench_flight(ground, &flight, &cam_pos, &cam_tau_angle, m);
+        const double t1 = pd_stub_time();
+        render_ground(ground, cam_pos, cam_tau_angle, m, 0, bitmap);
+        const double t2 = pd_stub_time();
+
+        update_times[k] = (float)((t1 - t0) * 1000.0);
+        render_times[k] = (float)((t2 - t1) * 1000.0);
+        frame_times[k] = update_times[k] + render_times[k];
+
+#ifdef LIB3D_PROFILE
+        FrameStatsSummary stats;
+        profile_get_stats(1, &stats);
+        for (int i = 0; i < PROFILE_STAGE_COUNT; i++) profile_total.stages[i] += stats.stages[i];
+        for (int i = 0; i < PROFILE_COUNTER_COUNT; i++) profile_total.counters[i] += stats.counters[i];
+#endif
+    }
+
+    if (pbm && !pd_stub_write_pbm(pbm, bitmap)) {
+        fprintf(stderr, "unable to write: %s\n", pbm);
+    }
+
+    printf("seed: %i track: %i render flags: %i frames: %i\n", seed, track_type, render_flags, frames);
+    printf("make_ground: %.3f ms\n", make_ms);
+    const char* names[] = { "update", "render", "frame" };
+    float* series[] = { update_times, render_times, frame_times };
+    printf("%-8s %9s %9s %9s %9s %9s\n", "ms", "mean", "p50", "p90", "p99", "max");
+    for (int s = 0; s < 3; s++) {
+        float* v = series[s];
+        double total = 0;
+        for (int k = 0; k < frames; k++) total += v[k];
+        qsort(v, frames, sizeof(float), cmp_float);
+        printf("%-8s %9.3f %9.3f %9.3f %9.3f %9.3f\n", names[s],
+            total / frames,
+            percentile(v, frames, 0.5f),
+            percentile(v, frames, 0.9f),
+            percentile(v, frames, 0.99f),
+            v[frames - 1]);
+    }
+
+    ArenaStats arena;
+    arena_get_stats(&arena);
+    printf("frame arena: peak %.1f KB (%.1f%% of %.1f KB)\n", arena.peak / 1024.f, 100.f * arena.peak / arena.capacity, arena.capacity / 1024.f);
+
+#ifdef LIB3D_PROFILE
+    printf("render stages (ms/frame):\n");
+    for (int i = 0; i < PROFILE_STAGE_COUNT; i++) {
+        printf("  %-12s %9.3f\n", _profile_stage_names[i], profile_total.stages[i] / frames);
+    }
+    printf("render counters (per frame):\n");
+    for (int i = 0; i < PROFILE_COUNTER_COUNT; i++) {
+        printf("  %-12s %9.1f\n", _profile_counter_names[i], profile_total.counters[i] / frames);
+    }
+    {
+        // perspective divides: shared vertex cache vs. one per tile drawable vertex
+        const float* counters = profile_total.counters;
+        const float projected = counters[PROFILE_COUNTER_PROJECTED] / frames, vertices = counters[PROFILE_COUNTER_TILE_VERTICES] / frames;
+        printf("tile projection: %.1f divides/frame (per drawable vertex: %.1f, saved: %.1f)\n", projected, vertices, vertices - projected);
+    }
+    if (render_flags & RENDER_FLAG_HORIZON_CULL) {
+        const float* counters = profile_total.counters;
+        const float hidden_tiles = counters[PROFILE_COUNTER_HIDDEN_TILES], hidden_props = counters[PROFILE_COUNTER_HIDDEN_PROPS];
+        const float tiles = counters[PROFILE_COUNTER_TILES] + hidden_tiles, props = counters[PROFILE_COUNTER_PROPS] + hidden_props;
+        printf("horizon culled: tiles %.1f%% props %.1f%%\n",
+            tiles > 0.f ? 100.f * hidden_tiles / tiles : 0.f,
+            props > 0.f ? 100.f * hidden_props / props : 0.f);
+    }
+#endif
+
+    free(update_times);
+    free(render_times);
+    free(frame_times);
+    free(patterns);
+    destroy_ground_context(ground);
+    return 0;
+}
@@ -0,0 +1,155 @@
+//
+//  pd_api.h
+//  host
+//
+//  Minimal stand-in for the Playdate SDK C API, restricted to the calls
+//  lib3d makes. Used to build & profile lib3d on a regular desktop host.
+//
+
+#ifndef pd_api_h
+#define pd_api_h
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+
+#define LCD_COLUMNS	400
+#define LCD_ROWS	240
+#define LCD_ROWSIZE 52
+
+// ***********************
+// system
+
+typedef enum
+{
+	kEventInit,
+	kEventInitLua,
+	kEventLock,
+	kEventUnlock,
+	kEventPause,
+	kEventResume,
+	kEventTerminate,
+	kEventKeyPressed,
+	kEventKeyReleased,
+	kEventLowPower
+} PDSystemEvent;
+
+struct playdate_sys
+{
+	void* (*realloc)(void* ptr, size_t size);
+	int (*formatString)(char** ret, const char* fmt, ...);
+	void (*logToConsole)(const char* fmt, ...);
+	void (*error)(const char* fmt, ...);
+	unsigned int (*getCurrentTimeMilliseconds)(void);
+	unsigned int (*getSecondsSinceEpoch)(unsigned int* milliseconds);
+	float (*getElapsedTime)(void);
+	void (*resetElapsedTime)(void);
+};
+
+// ***********************
+// file
+
+typedef void SDFile;
+
+typedef enum
+{
+	kFileRead = (1 << 0),
+	kFileReadData = (1 << 1),
+	kFileWrite = (1 << 2),
+	kFileAppend = (2 << 2)
+} FileOptions;
+
+struct playdate_file
+{
+	const char* (*geterr)(void);
+	SDFile* (*open)(const char* name, FileOptions mode);
+	int (*close)(SDFile* file);
+	int (*read)(SDFile* file, void* buf, unsigned int len);
+	int (*write)(SDFile* file, const void* buf, unsigned int len);
+};
+
+// ***********************
+// graphics
+
+typedef struct LCDBitmap LCDBitmap;
+typedef struct LCDBitmapTable LCDBitmapTable;
+
+typedef uintptr_t LCDColor;
+
+typedef enum
+{
+	kColorBlack,
+	kColorWhite,
+	kColorClear,
+	kColorXOR
+} LCDSolidColor;
+
+struct playdate_graphics
+{
+	void (*drawLine)(int x1, int y1, int x2, int y2, int width, LCDColor color);
+	LCDBitmapTable* (*loadBitmapTable)(const char* path, const char** outerr);
+	LCDBitmap* (*getTableBitmap)(LCDBitmapTable* table, int idx);
+	void (*freeBitmapTable)(LCDBitmapTable* table);
+	void (*getBitmapData)(LCDBitmap* bitmap, int* width, int* height, int* rowbytes, uint8_t** mask, uint8_t** data);
+	uint8_t* (*getFrame)(void);
+	void (*markUpdatedRows)(int start, int end);
+};
+
+// ***********************
+// lua
+
+typedef void* lua_State;
+typedef int (*lua_CFunction)(lua_State* L);
+typedef struct LuaUDObject LuaUDObject;
+
+typedef struct
+{
+	const char* name;
+	lua_CFunction func;
+} lua_reg;
+
+typedef struct
+{
+	const char* name;
+	int type;
+	union
+	{
+		unsigned int intval;
+		float floatval;
+		const char* strval;
+	} v;
+} lua_val;
+
+struct playdate_lua
+{
+	int (*addFunction)(lua_CFunction f, const char* name, const char** outErr);
+	int (*registerClass)(const char* name, const lua_reg* reg, const lua_val* vals, int isstatic, const char** outErr);
+
+	int (*getArgCount)(void);
+	int (*getArgInt)(int pos);
+	float (*getArgFloat)(int pos);
+	const char* (*getArgString)(int pos);
+	void* (*getArgObject)(int pos, char* type, LuaUDObject** outud);
+
+	void (*pushNil)(void);
+	void (*pushBool)(int val);
+	void (*pushInt)(int val);
+	void (*pushFloat)(float val);
+	void (*pushString)(const char* str);
+	LuaUDObject* (*pushObject)(void* obj, char* type, int nValues);
+};
+
+// ***********************
+// api
+
+typedef struct PlaydateAPI
+{
+	const struct playdate_sys* system;
+	const struct playdate_file* file;
+	const struct playdate_graphics* graphics;
+	const struct playdate_lua* lua;
+} PlaydateAPI;
+
+#endif
@@ -0,0 +1,388 @@
+//
+//  pd_stub.c
+//  host
+//
+//  Host implementation of the Playdate API subset declared in pd_api.h.
+//  Bitmap tables are synthesized (no .pdx assets on the host) and the
+//  display is an offscreen 400x240 1-bit buffer.
+//
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <time.h>
+#include "pd_stub.h"
+#include "luaglue.h"
+#include "ground.h"
+
+static uint8_t _frame[LCD_ROWSIZE * LCD_ROWS];
+static double _start_time = 0.0;
+// fixed elapsed time (< 0: live clock)
+static float _fixed_time = -1.f;
+
+double pd_stub_time() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// ***********************
+// system
+
+static void* sys_realloc(void* ptr, size_t size) {
+    if (size == 0) {
+        free(ptr);
+        return NULL;
+    }
+    return realloc(ptr, size);
+}
+
+static int sys_formatString(char** ret, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    const int len = vsnprintf(NULL, 0, fmt, args);
+    va_end(args);
+
+    *ret = malloc(len + 1);
+    va_start(args, fmt);
+    vsnprintf(*ret, len + 1, fmt, args);
+    va_end(args);
+    return len;
+}
+
+static void sys_logToConsole(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
+
+static void sys_error(const char* fmt, ...) {
+    va_list args;
+    fputs("error: ", stderr);
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fputc('\n', stderr);
+    // device halts on error
+    exit(1);
+}
+
+static unsigned int sys_getCurrentTimeMilliseconds() {
+    return (unsigned int)((pd_stub_time() - _start_time) * 1000.0);
+}
+
+static unsigned int sys_getSecondsSinceEpoch(unsigned int* milliseconds) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    if (milliseconds) *milliseconds = (unsigned int)(ts.tv_nsec / 1000000);
+    return (unsigned int)ts.tv_sec;
+}
+
+static float sys_getElapsedTime() {
+    if (_fixed_time >= 0.f) return _fixed_time;
+    return (float)(pd_stub_time() - _start_time);
+}
+
+void pd_stub_set_elapsed_time(float t) {
+    _fixed_time = t;
+}
+
+static void sys_resetElapsedTime() {
+    _start_time = pd_stub_time();
+}
+
+static const struct playdate_sys _sys = {
+    .realloc = sys_realloc,
+    .formatString = sys_formatString,
+    .logToConsole = sys_logToConsole,
+    .error = sys_error,
+    .getCurrentTimeMilliseconds = sys_getCurrentTimeMilliseconds,
+    .getSecondsSinceEpoch = sys_getSecondsSinceEpoch,
+    .getElapsedTime = sys_getElapsedTime,
+    .resetElapsedTime = sys_resetElapsedTime
+};
+
+// ***********************
+// file (host files, relative to working directory)
+
+static const char* _file_err = NULL;
+
+static const char* file_geterr() {
+    return _file_err;
+}
+
+static SDFile* file_open(const char* name, FileOptions mode) {
+    const char* fmode = (mode & kFileAppend) == kFileAppend ? "ab" : (mode & kFileWrite) ? "wb" : "rb";
+    FILE* f = fopen(name, fmode);
+    _file_err = f ? NULL : "unable to open file";
+    return f;
+}
+
+static int file_close(SDFile* file) {
+    return fclose((FILE*)file) ? -1 : 0;
+}
+
+static int file_read(SDFile* file, void* buf, unsigned int len) {
+    const size_t n = fread(buf, 1, len, (FILE*)file);
+    if (n < len && ferror((FILE*)file)) {
+        _file_err = "read error";
+        return -1;
+    }
+    return (int)n;
+}
+
+static int file_write(SDFile* file, const void* buf, unsigned int len) {
+    const size_t n = fwrite(buf, 1, len, (FILE*)file);
+    if (n < len) {
+        _file_err = "write error";
+        return -1;
+    }
+    return (int)n;
+}
+
+static const struct playdate_file _file = {
+    .geterr = file_geterr,
+    .open = file_open,
+    .close = file_close,
+    .read = file_read,
+    .write = file_write
+};
+
+// ***********************
+// graphics
+
+struct LCDBitmap {
+    int width;
+    int height;
+    int rowbytes;
+    uint8_t* data;
+};
+
+struct LCDBitmapTable {
+    int n;
+    LCDBitmap* bitmaps;
+};
+
+// 32x32 ordered (Bayer) threshold in [0;1024[
+static int bayer32(int x, int y) {
+    // interleave (x^y, y) bits, finest bits first
+    int v = 0;
+    for (int bit = 0; bit < 5; bit++) {
+        const int xb = (x >> bit) & 1, yb = (y >> bit) & 1;
+        v = (v << 2) | ((xb ^ yb) << 1) | yb;
+    }
+    return v;
+}
+
+// 32x32 white noise threshold in [0;1024[
+static int noise32(int x, int y) {
+    uint32_t h = (uint32_t)x * 374761393u + (uint32_t)y * 668265263u;
+    h = (h ^ (h >> 13)) * 1274126177u;
+    return (int)((h ^ (h >> 16)) & 1023);
+}
+
+// 16 levels of 32x32 dither, from black (0) to white (15)
+static LCDBitmapTable* make_dither_table(int(*threshold)(int, int)) {
+    LCDBitmapTable* table = calloc(1, sizeof(LCDBitmapTable));
+    table->n = 16;
+    table->bitmaps = calloc(table->n, sizeof(LCDBitmap));
+    for (int i = 0; i < table->n; i++) {
+        LCDBitmap* bitmap = &table->bitmaps[i];
+        bitmap->width = bitmap->height = 32;
+        bitmap->rowbytes = 4;
+        bitmap->data = calloc(32 * 4, 1);
+        const int level = (i * 1024) / 15;
+        for (int y = 0; y < 32; y++) {
+            for (int x = 0; x < 32; x++) {
+                if (threshold(x, y) < level)
+                    bitmap->data[y * 4 + x / 8] |= 0x80 >> (x & 7);
+            }
+        }
+    }
+    return table;
+}
+
+// rotated sky backgrounds (-30..30 degrees): mountains silhouette over a flat sky
+static LCDBitmapTable* make_sky_table() {
+    LCDBitmapTable* table = calloc(1, sizeof(LCDBitmapTable));
+    table->n = 61;
+    table->bitmaps = calloc(table->n, sizeof(LCDBitmap));
+    for (int i = 0; i < table->n; i++) {
+        LCDBitmap* bitmap = &table->bitmaps[i];
+        bitmap->width = LCD_COLUMNS;
+        bitmap->height = 96;
+        bitmap->rowbytes = LCD_COLUMNS / 8;
+        bitmap->data = calloc(bitmap->rowbytes * bitmap->height, 1);
+        const float slope = tanf((i - 30) * 3.1415927f / 180.f);
+        for (int y = 0; y < bitmap->height; y++) {
+            for (int x = 0; x < LCD_COLUMNS; x++) {
+                const float ridge = 48.f + slope * (x - 200) + 12.f * sinf(x * 0.03f) + 5.f * sinf(x * 0.11f);
+                if (y < ridge)
+                    bitmap->data[y * bitmap->rowbytes + x / 8] |= 0x80 >> (x & 7);
+            }
+        }
+    }
+    return table;
+}
+
+static void gfx_drawLine(int x1, int y1, int x2, int y2, int width, LCDColor color) {
+    // bresenham (width ignored)
+    const int dx = abs(x2 - x1), sx = x1 < x2 ? 1 : -1;
+    const int dy = -abs(y2 - y1), sy = y1 < y2 ? 1 : -1;
+    int err = dx + dy;
+    for (;;) {
+        if (x1 >= 0 && x1 < LCD_COLUMNS && y1 >= 0 && y1 < LCD_ROWS) {
+            uint8_t* p = &_frame[y1 * LCD_ROWSIZE + x1 / 8];
+            const uint8_t bit = 0x80 >> (x1 & 7);
+            if (color == kColorWhite) *p |= bit; else *p &= ~bit;
+        }
+        if (x1 == x2 && y1 == y2) break;
+        const int e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x1 += sx; }
+        if (e2 <= dx) { err += dx; y1 += sy; }
+    }
+}
+
+static LCDBitmapTable* gfx_loadBitmapTable(const char* path, const char** outerr) {
+    if (strstr(path, "bayer-noise32x32"))
+        return make_dither_table(bayer32);
+    if (strstr(path, "noise32x32"))
+        return make_dither_table(noise32);
+    if (strstr(path, "sky_background"))
+        return make_sky_table();
+    if (outerr) *outerr = "no host substitute for bitmap table";
+    return NULL;
+}
+
+static LCDBitmap* gfx_getTableBitmap(LCDBitmapTable* table, int idx) {
+    if (!table || idx < 0 || idx >= table->n)
+        return NULL;
+    return &table->bitmaps[idx];
+}
+
+static void gfx_freeBitmapTable(LCDBitmapTable* table) {
+    if (!table) return;
+    for (int i = 0; i < table->n; i++) {
+        free(table->bitmaps[i].data);
+    }
+    free(table->bitmaps);
+    free(table);
+}
+
+static void gfx_getBitmapData(LCDBitmap* bitmap, int* width, int* height, int* rowbytes, uint8_t** mask, uint8_t** data) {
+    if (!bitmap) return;
+    if (width) *width = bitmap->width;
+    if (height) *height = bitmap->height;
+    if (rowbytes) *rowbytes = bitmap->rowbytes;
+    if (mask) *mask = NULL;
+    if (data) *data = bitmap->data;
+}
+
+static uint8_t* gfx_getFrame() {
+    return _frame;
+}
+
+static void gfx_markUpdatedRows(int start, int end) {
+}
+
+static const struct playdate_graphics _graphics = {
+    .drawLine = gfx_drawLine,
+    .loadBitmapTable = gfx_loadBitmapTable,
+    .getTableBitmap = gfx_getTableBitmap,
+    .freeBitmapTable = gfx_freeBitmapTable,
+    .getBitmapData = gfx_getBitmapData,
+    .getFrame = gfx_getFrame,
+    .markUpdatedRows = gfx_markUpdatedRows
+};
+
+// ***********************
+// lua (registration only, no interpreter)
+
+static int lua_addFunction(lua_CFunction f, const char* name, const char** outErr) {
+    return 1;
+}
+
+static int lua_registerClass(const char* name, const lua_reg* reg, const lua_val* vals, int isstatic, const char** outErr) {
+    return 1;
+}
+
+static int lua_getArgCount() { return 0; }
+static int lua_getArgInt(int pos) { return 0; }
+static float lua_getArgFloat(int pos) { return 0.f; }
+static const char* lua_getArgString(int pos) { return ""; }
+static void* lua_getArgObject(int pos, char* type, LuaUDObject** outud) { return NULL; }
+static void lua_pushNil() {}
+static void lua_pushBool(int val) {}
+static void lua_pushInt(int val) {}
+static void lua_pushFloat(float val) {}
+static void lua_pushString(const char* str) {}
+static LuaUDObject* lua_pushObject(void* obj, char* type, int nValues) { return NULL; }
+
+static const struct playdate_lua _lua = {
+    .addFunction = lua_addFunction,
+    .registerClass = lua_registerClass,
+    .getArgCount = lua_getArgCount,
+    .getArgInt = lua_getArgInt,
+    .getArgFloat = lua_getArgFloat,
+    .getArgString = lua_getArgString,
+    .getArgObject = lua_getArgObject,
+    .pushNil = lua_pushNil,
+    .pushBool = lua_pushBool,
+    .pushInt = lua_pushInt,
+    .pushFloat = lua_pushFloat,
+    .pushString = lua_pushString,
+    .pushObject = lua_pushObject
+};
+
+// ***********************
+// api
+
+static PlaydateAPI _api = {
+    .system = &_sys,
+    .file = &_file,
+    .graphics = &_graphics,
+    .lua = &_lua
+};
+
+PlaydateAPI* pd_stub_init() {
+    _start_time = pd_stub_time();
+    memset(_frame, 0xff, sizeof(_frame));
+    return &_api;
+}
+
+PlaydateAPI* pd_stub_init_lib3d(const int budget) {
+    PlaydateAPI* pd = pd_stub_init();
+    pd_stub_set_elapsed_time(1.f);
+    lib3d_register(pd);
+    if (budget >= 0) set_generation_budget(budget);
+    while (ground_load_assets_async());
+    return pd;
+}
+
+uint64_t pd_stub_hash_bytes(uint64_t h, const void* data, const size_t n) {
+    const uint8_t* p = (const uint8_t*)data;
+    for (size_t i = 0; i < n; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+uint8_t* pd_stub_frame() {
+    return _frame;
+}
+
+int pd_stub_write_pbm(const char* path, const uint8_t* bitmap) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return 0;
+    fprintf(f, "P4\n%d %d\n", LCD_COLUMNS, LCD_ROWS);
+    for (int j = 0; j < LCD_ROWS; j++) {
+        for (int i = 0; i < LCD_COLUMNS / 8; i++) {
+            // pbm: 1 is black
+            fputc(~bitmap[j * LCD_ROWSIZE + i] & 0xff, f);
+        }
+    }
+    fclose(f);
+    return 1;
+}
@@ -0,0 +1,30 @@
+#ifndef pd_stub_h
+#define pd_stub_h
+
+#include <pd_api.h>
+
+// returns the host implementation of the Playdate API
+PlaydateAPI* pd_stub_init();
+
+// offscreen 1-bit 400x240 frame (LCD_ROWSIZE bytes per row, 1: white)
+uint8_t* pd_stub_frame();
+
+// host monotonic clock (in seconds)
+double pd_stub_time();
+
+// freezes system->getElapsedTime to t (for reproducible frames), t < 0 restores the clock
+void pd_stub_set_elapsed_time(float t);
+
+// write the given 1-bit frame as a binary PBM image
+int pd_stub_write_pbm(const char* path, const uint8_t* bitmap);
+
+// FNV-1a hash (bit exact frame & query traces)
+#define PD_STUB_HASH_SEED 0xcbf29ce484222325ull
+uint64_t pd_stub_hash_bytes(uint64_t h, const void* data, const size_t n);
+
+// common setup of the replay checks: host API with frozen elapsed time (time based animations),
+// lib3d registered and assets loaded
+// budget: slice generation budget in us (< 0: default)
+PlaydateAPI* pd_stub_init_lib3d(const int budget);
+
+#endif
@@ -0,0 +1,66 @@
+//
+//  perlin_bench.c
+//  host
+//
+//  Compares a slice worth of scalar perlin2d calls vs. perlin2d_row
+//  (same parameters as make_slice) and checks both agree.
+//
+//  usage: perlin_bench [-i iterations]
+//
+
+#include <stdio.h>
+#include <math.h>
+#include "pd_stub.h"
+#include "perlin.h"
+
+// max. absolute difference (noise is in [0;1])
+#define PERLIN_TOLERANCE 1e-6f
+
+int main(int argc, char** argv) {
+    int iterations = 20000;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-i") && i + 1 < argc) iterations = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [-i iterations]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (iterations < 1) iterations = 1;
+
+    float a[GROUND_WIDTH], b[GROUND_WIDTH];
+    // prevent dead code elimination
+    float sink = 0.f;
+    float max_error = 0.f;
+    int exact = 1;
+    double scalar_time = 0, row_time = 0;
+    for (int k = 0; k < iterations; k++) {
+        // same y progression as make_slice (noise_y_offset)
+        const float y = 16.f * (k % 97) / 97.f + 0.6f * k;
+
+        double t0 = pd_stub_time();
+        for (int i = 0; i < GROUND_WIDTH; i++) {
+            a[i] = perlin2d((16.f * i) / GROUND_WIDTH, y, 0.25f, 4);
+        }
+        scalar_time += pd_stub_time() - t0;
+
+        t0 = pd_stub_time();
+        perlin2d_row(y, 0.25f, 4, b);
+        row_time += pd_stub_time() - t0;
+
+        for (int i = 0; i < GROUND_WIDTH; i++) {
+            const float e = fabsf(a[i] - b[i]);
+            if (e > max_error) max_error = e;
+            if (a[i] != b[i]) exact = 0;
+            sink += a[i] + b[i];
+        }
+    }
+    scalar_time *= 1e6 / iterations;
+    row_time *= 1e6 / iterations;
+
+    printf("%-12s %12s\n", "us/slice", "");
+    printf("%-12s %12.3f\n", "perlin2d", scalar_time);
+    printf("%-12s %12.3f\n", "perlin2d_row", row_time);
+    printf("speedup: %.2fx max error: %g%s (checksum: %g)\n", scalar_time / row_time, max_error, exact ? " (bit exact)" : "", sink);
+
+    return max_error > PERLIN_TOLERANCE;
+}
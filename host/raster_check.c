@@ -0,0 +1,458 @@
+//
+//  raster_check.c
+//  host
+//
+//  Golden image check of the rasterizers (polyfill, texfill, alphafill, texalphafill):
+//  a deterministic corpus of polygons (slivers, off-screen, clipped, huge,
+//  degenerate, near plane clipped 5-gons, word boundary spans, S-buffer overlaps)
+//  is rendered and compared to the PBM images in host/golden.
+//  Reports pixel diffs per image and fill throughput per primitive.
+//
+//  --update: (re)writes the golden images
+//  -o: writes mismatching images to the given directory
+//
+//  usage: raster_check [--update] [-g golden dir] [-o output dir] [-n repeat]
+//
+
+#include <stdio.h>
+#include <math.h>
+#include "pd_stub.h"
+#include "gfx.h"
+
+#ifndef GOLDEN_DIR
+#define GOLDEN_DIR "golden"
+#endif
+
+#define MAX_POLYS 384
+#define MAX_VERTS 5
+
+#define PRIM_POLYFILL 0
+#define PRIM_TEXFILL 1
+#define PRIM_ALPHAFILL 2
+#define PRIM_TEXALPHAFILL 3
+#define PRIMS 4
+static const char* _prim_names[PRIMS] = { "polyfill", "texfill", "alphafill", "texalphafill" };
+
+typedef struct {
+    int n;
+    Point3du pts[MAX_VERTS];
+    // dither/ramp/alpha table
+    int table;
+    // S-buffer key
+    uint16_t key;
+} TestPoly;
+
+typedef struct {
+    const char* name;
+    int sbuffer;
+    int n;
+    TestPoly polys[MAX_POLYS];
+} TestGroup;
+
+// xorshift (independent from lib3d generators)
+static uint32_t _state;
+static uint32_t next_u32() {
+    _state ^= _state << 13;
+    _state ^= _state >> 17;
+    _state ^= _state << 5;
+    return _state;
+}
+static float next_float() {
+    return (next_u32() >> 8) / 16777216.f;
+}
+static float next_range(const float a, const float b) {
+    return a + (b - a) * next_float();
+}
+
+// dither tables
+#define TABLES 16
+static uint32_t _dithers[TABLES][32];
+static uint8_t _ramps[TABLES][8 * 32 * 16];
+static uint8_t _background[LCD_ROWSIZE * LCD_ROWS];
+
+static void make_tables() {
+    _state = 0x9E3779B9;
+    for (int t = 0; t < TABLES; t++) {
+        for (int i = 0; i < 32; i++) _dithers[t][i] = next_u32();
+        // game layout: 8 bytes per shade, 4 columns repeated twice
+        for (int i = 0; i < 8 * 32 * 16; i++) {
+            const uint8_t v = (uint8_t)next_u32();
+            _ramps[t][i] = (i & 4) ? _ramps[t][i - 4] : v;
+        }
+    }
+    // black & white stripes: catches spurious set & cleared pixels
+    for (int j = 0; j < LCD_ROWS; j++) memset(_background + j * LCD_ROWSIZE, (j & 4) ? 0xff : 0, LCD_ROWSIZE);
+}
+
+// vertex order as produced by the game projection (left edge: increasing index)
+static TestPoly* push_poly(TestGroup* group, const int n) {
+    TestPoly* poly = &group->polys[group->n++];
+    poly->n = n;
+    poly->table = next_u32() % TABLES;
+    poly->key = (uint16_t)group->n;
+    for (int i = 0; i < n; i++) {
+        // shading (ramp index)
+        poly->pts[i].u = next_range(0.f, 14.f);
+        poly->pts[i].z = 1.f;
+        poly->pts[i].light = 1.f;
+    }
+    return poly;
+}
+
+static void set_vert(TestPoly* poly, const int i, const float x, const float y) {
+    poly->pts[i].x = x;
+    poly->pts[i].y = y;
+}
+
+// regular polygon
+static TestPoly* push_ngon(TestGroup* group, const int n, const float x, const float y, const float r, const float angle) {
+    TestPoly* poly = push_poly(group, n);
+    for (int i = 0; i < n; i++) {
+        const float a = angle - 2.f * PI * i / n;
+        set_vert(poly, i, x + r * cosf(a), y + r * sinf(a));
+    }
+    return poly;
+}
+
+static TestPoly* push_quad(TestGroup* group, const float x0, const float y0, const float x1, const float y1) {
+    TestPoly* poly = push_poly(group, 4);
+    set_vert(poly, 0, x0, y0);
+    set_vert(poly, 1, x0, y1);
+    set_vert(poly, 2, x1, y1);
+    set_vert(poly, 3, x1, y0);
+    return poly;
+}
+
+static void make_slivers(TestGroup* group) {
+    // thin triangles (any direction)
+    for (int i = 0; i < 48; i++) {
+        const float x = next_range(0.f, LCD_COLUMNS), y = next_range(0.f, LCD_ROWS);
+        const float a = next_range(0.f, 2.f * PI), len = next_range(20.f, 300.f), w = next_range(0.05f, 1.5f);
+        const float dx = cosf(a), dy = sinf(a);
+        TestPoly* poly = push_poly(group, 3);
+        set_vert(poly, 0, x, y);
+        set_vert(poly, 1, x + len * dx - w * dy, y + len * dy + w * dx);
+        set_vert(poly, 2, x + len * dx, y + len * dy);
+    }
+    // 1 pixel wide/high quads across word boundaries
+    for (int i = 0; i < 16; i++) {
+        const float x = 32.f * (i + 1) - 0.5f + 0.1f * i;
+        push_quad(group, x, 4.f + 12.f * i, x + 1.f, 200.f);
+        push_quad(group, 10.f + 7.f * i, 220.f + i, 390.f - 3.f * i, 220.6f + i);
+    }
+}
+
+static void make_offscreen(TestGroup* group) {
+    // fully outside each side + exactly touching the screen border
+    const float d = 50.f;
+    for (int i = 0; i < 8; i++) {
+        const float r = next_range(5.f, 40.f);
+        push_ngon(group, 4, -d - r - 10.f * i, next_range(0.f, LCD_ROWS), r, next_float());
+        push_ngon(group, 4, LCD_COLUMNS + d + r + 10.f * i, next_range(0.f, LCD_ROWS), r, next_float());
+        push_ngon(group, 4, next_range(0.f, LCD_COLUMNS), -d - r - 10.f * i, r, next_float());
+        push_ngon(group, 4, next_range(0.f, LCD_COLUMNS), LCD_ROWS + d + r + 10.f * i, r, next_float());
+    }
+    push_quad(group, -20.f, 10.f, 0.f, 50.f);
+    push_quad(group, LCD_COLUMNS, 10.f, LCD_COLUMNS + 20.f, 50.f);
+    push_quad(group, 10.f, -20.f, 50.f, 0.f);
+    push_quad(group, 10.f, LCD_ROWS, 50.f, LCD_ROWS + 20.f);
+    // inside, as a reference
+    push_quad(group, 100.f, 100.f, 300.f, 140.f);
+}
+
+static void make_clipped(TestGroup* group) {
+    // centers around the screen border
+    for (int i = 0; i < 64; i++) {
+        float x, y;
+        switch (i & 3) {
+        case 0: x = next_range(-20.f, 20.f), y = next_range(0.f, LCD_ROWS); break;
+        case 1: x = next_range(LCD_COLUMNS - 20.f, LCD_COLUMNS + 20.f), y = next_range(0.f, LCD_ROWS); break;
+        case 2: x = next_range(0.f, LCD_COLUMNS), y = next_range(-20.f, 20.f); break;
+        default: x = next_range(0.f, LCD_COLUMNS), y = next_range(LCD_ROWS - 20.f, LCD_ROWS + 20.f); break;
+        }
+        push_ngon(group, 3 + (i % 3), x, y, next_range(8.f, 60.f), next_range(0.f, 2.f * PI));
+    }
+    // corners
+    push_ngon(group, 4, 0.f, 0.f, 30.f, 0.3f);
+    push_ngon(group, 4, LCD_COLUMNS, 0.f, 30.f, 0.7f);
+    push_ngon(group, 4, 0.f, LCD_ROWS, 30.f, 1.1f);
+    push_ngon(group, 4, LCD_COLUMNS, LCD_ROWS, 30.f, 1.5f);
+}
+
+static void make_huge(TestGroup* group) {
+    push_ngon(group, 4, 200.f, 120.f, 20000.f, 0.2f);
+    // screen wide edges
+    for (int i = 0; i < 6; i++) {
+        TestPoly* poly = push_poly(group, 3);
+        const float y = 20.f + 40.f * i;
+        set_vert(poly, 0, -5000.f, y - 3000.f);
+        set_vert(poly, 1, -5000.f + 40.f * i, y + 3000.f);
+        set_vert(poly, 2, 5000.f, y + 10.f * i);
+    }
+    push_ngon(group, 5, 200.f, 120.f, 1000.f, 0.9f);
+    push_ngon(group, 3, 150.f, 400.f, 340.f, 1.3f);
+}
+
+static void make_degenerate(TestGroup* group) {
+    for (int i = 0; i < 12; i++) {
+        const float x = next_range(0.f, LCD_COLUMNS), y = next_range(0.f, LCD_ROWS);
+        // collinear
+        TestPoly* poly = push_poly(group, 3);
+        set_vert(poly, 0, x, y);
+        set_vert(poly, 1, x + 20.f, y + 10.f);
+        set_vert(poly, 2, x + 40.f, y + 20.f);
+        // single point
+        poly = push_poly(group, 3);
+        set_vert(poly, 0, x, y);
+        set_vert(poly, 1, x, y);
+        set_vert(poly, 2, x, y);
+        // duplicated vertices
+        poly = push_poly(group, 5);
+        set_vert(poly, 0, x, y);
+        set_vert(poly, 1, x, y);
+        set_vert(poly, 2, x - 10.f, y + 30.f);
+        set_vert(poly, 3, x + 25.f, y + 30.f);
+        set_vert(poly, 4, x + 25.f, y + 30.f);
+        // zero height
+        poly = push_poly(group, 4);
+        const float yi = floorf(y) + 0.5f * (i & 1);
+        set_vert(poly, 0, x, yi);
+        set_vert(poly, 1, x + 10.f, yi);
+        set_vert(poly, 2, x + 60.f, yi);
+        set_vert(poly, 3, x + 30.f, yi);
+        // reversed winding
+        poly = push_poly(group, 3);
+        set_vert(poly, 0, x, y);
+        set_vert(poly, 1, x + 30.f, y + 20.f);
+        set_vert(poly, 2, x - 10.f, y + 40.f);
+    }
+    // integer coordinates (exact pixel centers & edges)
+    push_quad(group, 8.f, 8.f, 40.f, 40.f);
+    push_quad(group, 64.5f, 8.5f, 96.5f, 40.5f);
+}
+
+static void make_near_clip(TestGroup* group) {
+    // quads clipped by the near plane: 5 vertices, 2 of them far off screen
+    for (int i = 0; i < 32; i++) {
+        const float x = next_range(0.f, LCD_COLUMNS), y = next_range(60.f, LCD_ROWS);
+        const float far_x = next_range(-4000.f, 4000.f), far_y = next_range(2000.f, 8000.f);
+        const float w = next_range(10.f, 80.f);
+        TestPoly* poly = push_poly(group, 5);
+        set_vert(poly, 0, x, y - next_range(10.f, 60.f));
+        set_vert(poly, 1, x - w, y);
+        set_vert(poly, 2, far_x - w, far_y);
+        set_vert(poly, 3, far_x + w, far_y + next_range(-1.f, 1.f));
+        set_vert(poly, 4, x + w, y + next_range(-0.01f, 0.01f));
+    }
+}
+
+static void make_word_edges(TestGroup* group) {
+    // spans starting/ending on each side of 8 & 32 bit boundaries
+    static const float offsets[] = { -1.f, -0.5f, 0.f, 0.5f, 1.f };
+    const int n = sizeof(offsets) / sizeof(offsets[0]);
+    float y = 0.f;
+    for (int a = 0; a < 6; a++) {
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++, y += 3.f) {
+                const float x0 = 32.f * a + 8.f * (a & 1) + offsets[i];
+                const float x1 = x0 + 8.f * (1 + a + j) + 32.f * (a & 2) + offsets[j];
+                push_quad(group, x0, y, x1, y + 2.f);
+                push_quad(group, LCD_COLUMNS - x1, y, LCD_COLUMNS - x0 + 1.f * i, y + 2.f);
+            }
+            if (y > LCD_ROWS - 3.f) y = 1.f;
+        }
+    }
+}
+
+static void make_sbuffer(TestGroup* group) {
+    group->sbuffer = 1;
+    // overlapping polygons (front to back order)
+    for (int i = 0; i < 96; i++) {
+        push_ngon(group, 3 + (i % 3), next_range(0.f, LCD_COLUMNS), next_range(0.f, LCD_ROWS), next_range(5.f, 80.f), next_range(0.f, 2.f * PI));
+    }
+}
+
+typedef void(*make_group)(TestGroup* group);
+static struct {
+    const char* name;
+    make_group make;
+} _groups[] = {
+    { "slivers", make_slivers },
+    { "offscreen", make_offscreen },
+    { "clipped", make_clipped },
+    { "huge", make_huge },
+    { "degenerate", make_degenerate },
+    { "near_clip", make_near_clip },
+    { "word_edges", make_word_edges },
+    { "sbuffer", make_sbuffer },
+};
+#define GROUPS (sizeof(_groups) / sizeof(_groups[0]))
+
+static void draw_poly(const TestPoly* poly, const int prim, const int i, uint8_t* bitmap) {
+    switch (prim) {
+    case PRIM_POLYFILL: polyfill(poly->pts, poly->n, _dithers[poly->table], (uint32_t*)bitmap); break;
+    case PRIM_TEXFILL: texfill(poly->pts, poly->n, _ramps[poly->table], bitmap); break;
+    case PRIM_ALPHAFILL: alphafill(poly->pts, poly->n, (i & 1) ? 0xffffffff : 0, _dithers[poly->table], (uint32_t*)bitmap); break;
+    case PRIM_TEXALPHAFILL: texalphafill(poly->pts, poly->n, _ramps[poly->table], _dithers[(poly->table + i) % TABLES], bitmap); break;
+    }
+}
+
+static void draw_group(const TestGroup* group, const int prim, uint8_t* bitmap) {
+    if (!group->sbuffer) {
+        for (int i = 0; i < group->n; i++) draw_poly(&group->polys[i], prim, i, bitmap);
+        return;
+    }
+    // game order: opaque front to back, then transparent back to front
+    sbuffer_begin();
+    for (int i = 0; i < group->n; i++) {
+        sbuffer_set_key(group->polys[i].key);
+        draw_poly(&group->polys[i], prim == PRIM_ALPHAFILL ? (i & 1) : prim == PRIM_TEXALPHAFILL ? PRIM_TEXFILL : prim, i, bitmap);
+    }
+    if (prim == PRIM_ALPHAFILL || prim == PRIM_TEXALPHAFILL) {
+        for (int i = group->n - 1; i >= 0; i--) {
+            // particles in between the opaque polygons
+            sbuffer_set_key(group->polys[i].key + 1);
+            TestPoly poly = group->polys[i];
+            for (int k = 0; k < poly.n; k++) {
+                poly.pts[k].x += 20.f;
+                poly.pts[k].y -= 10.f;
+            }
+            draw_poly(&poly, prim, i, bitmap);
+        }
+    }
+    sbuffer_end();
+}
+
+static int read_pbm(const char* path, uint8_t* bitmap) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return 0;
+    int w = 0, h = 0;
+    int res = fscanf(f, "P4 %d %d", &w, &h) == 2 && w == LCD_COLUMNS && h == LCD_ROWS && fgetc(f) != EOF;
+    for (int j = 0; j < LCD_ROWS && res; j++) {
+        res = fread(bitmap + j * LCD_ROWSIZE, 1, LCD_COLUMNS / 8, f) == LCD_COLUMNS / 8;
+        for (int i = 0; i < LCD_COLUMNS / 8; i++) bitmap[j * LCD_ROWSIZE + i] ^= 0xff;
+    }
+    fclose(f);
+    return res;
+}
+
+static int count_bits(uint32_t v) {
+    int n = 0;
+    for (; v; v &= v - 1) n++;
+    return n;
+}
+
+// pixels covered by polygon (solid fill)
+static int coverage(const TestPoly* poly, uint8_t* bitmap) {
+    static uint32_t solid[32];
+    memset(solid, 0xff, sizeof(solid));
+    memset(bitmap, 0, LCD_ROWSIZE * LCD_ROWS);
+    polyfill(poly->pts, poly->n, solid, (uint32_t*)bitmap);
+    int n = 0;
+    for (int i = 0; i < LCD_ROWSIZE * LCD_ROWS; i++) n += count_bits(bitmap[i]);
+    return n;
+}
+
+static TestGroup _corpus[GROUPS];
+
+int main(int argc, char** argv) {
+    int update = 0;
+    int repeat = 50;
+    const char* golden_dir = GOLDEN_DIR;
+    const char* output_dir = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--update")) update = 1;
+        else if (!strcmp(argv[i], "-g") && i + 1 < argc) golden_dir = argv[++i];
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) output_dir = argv[++i];
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc) repeat = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [--update] [-g golden dir] [-o output dir] [-n repeat]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (repeat < 1) repeat = 1;
+
+    PlaydateAPI* pd = pd_stub_init();
+    gfx_init(pd);
+
+    make_tables();
+    for (int g = 0; g < (int)GROUPS; g++) {
+        _state = 0x1234567 + 7919 * g;
+        _corpus[g].name = _groups[g].name;
+        _groups[g].make(&_corpus[g]);
+    }
+
+    // correctness
+    uint8_t* bitmap = pd_stub_frame();
+    static uint8_t golden[LCD_ROWSIZE * LCD_ROWS];
+    char path[512];
+    int failed = 0, images = 0;
+    for (int g = 0; g < (int)GROUPS; g++) {
+        for (int prim = 0; prim < PRIMS; prim++, images++) {
+            memcpy(bitmap, _background, sizeof(_background));
+            draw_group(&_corpus[g], prim, bitmap);
+            snprintf(path, sizeof(path), "%s/%s_%s.pbm", golden_dir, _prim_names[prim], _corpus[g].name);
+            if (update) {
+                if (!pd_stub_write_pbm(path, bitmap)) {
+                    fprintf(stderr, "unable to write: %s\n", path);
+                    failed = 1;
+                }
+                continue;
+            }
+            if (!read_pbm(path, golden)) {
+                fprintf(stderr, "unable to read: %s\n", path);
+                failed = 1;
+                continue;
+            }
+            int diffs = 0, x0 = LCD_COLUMNS, y0 = LCD_ROWS, x1 = -1, y1 = -1;
+            for (int j = 0; j < LCD_ROWS; j++) {
+                for (int i = 0; i < LCD_COLUMNS / 8; i++) {
+                    const uint8_t d = bitmap[j * LCD_ROWSIZE + i] ^ golden[j * LCD_ROWSIZE + i];
+                    if (!d) continue;
+                    diffs += count_bits(d);
+                    if (8 * i < x0) x0 = 8 * i;
+                    if (8 * i + 7 > x1) x1 = 8 * i + 7;
+                    if (j < y0) y0 = j;
+                    y1 = j;
+                }
+            }
+            if (diffs) {
+                printf("%-10s %-12s FAILED: %i pixels differ in [%i,%i]x[%i,%i]\n", _prim_names[prim], _corpus[g].name, diffs, x0, x1, y0, y1);
+                failed = 1;
+                if (output_dir) {
+                    snprintf(path, sizeof(path), "%s/%s_%s.pbm", output_dir, _prim_names[prim], _corpus[g].name);
+                    pd_stub_write_pbm(path, bitmap);
+                }
+            }
+        }
+    }
+    if (update) {
+        printf("updated: %i images in: %s\n", images, golden_dir);
+        return failed;
+    }
+    printf("golden images: %i %s\n", images, failed ? "FAILED" : "ok");
+
+    // throughput (entire corpus)
+    // note: S-buffer group not included (pixel count depends on draw order)
+    int polys = 0;
+    double pixels = 0;
+    for (int g = 0; g < (int)GROUPS; g++) {
+        if (_corpus[g].sbuffer) continue;
+        for (int i = 0; i < _corpus[g].n; i++) pixels += coverage(&_corpus[g].polys[i], bitmap);
+        polys += _corpus[g].n;
+    }
+    printf("corpus: %i polygons %.0f pixels\n", polys, pixels);
+    for (int prim = 0; prim < PRIMS; prim++) {
+        memcpy(bitmap, _background, sizeof(_background));
+        const double t0 = pd_stub_time();
+        for (int r = 0; r < repeat; r++) {
+            for (int g = 0; g < (int)GROUPS; g++) {
+                if (_corpus[g].sbuffer) continue;
+                for (int i = 0; i < _corpus[g].n; i++) draw_poly(&_corpus[g].polys[i], prim, i, bitmap);
+            }
+        }
+        const double t = (pd_stub_time() - t0) / repeat;
+        printf("%-10s %8.3fms/corpus %8.1f ns/polygon %8.3f ns/pixel\n", _prim_names[prim], 1000.0 * t, 1e9 * t / polys, 1e9 * t / pixels);
+    }
+    return failed;
+}
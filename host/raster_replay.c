@@ -0,0 +1,108 @@
+//
+//  raster_replay.c
+//  host
+//
+//  Replays captured raster commands (see capture.h, input_replay -c or lib3d.capture_frames)
+//  straight into polyfill/texfill/alphafill: rasterizer cost only, no ground or geometry stages.
+//  Output of every frame is checked against the captured frame.
+//
+//  usage: raster_replay [-n repeat] capture
+//
+
+#include <stdio.h>
+#include <float.h>
+#include "pd_stub.h"
+#include "luaglue.h"
+#include "realloc.h"
+#include "capture.h"
+
+static uint8_t* read_file(const char* path, int* size) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    *size = (int)ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* data = lib3d_malloc(*size);
+    if (fread(data, 1, *size, f) != (size_t)*size) {
+        lib3d_free(data);
+        data = NULL;
+    }
+    fclose(f);
+    return data;
+}
+
+static const char* _command_names[] = { "", "polyfill", "texfill", "alphafill", "sbuffer_begin", "sbuffer_end", "sbuffer_key", "sbuffer_line", "line", "texalphafill" };
+#define COMMAND_TYPES (sizeof(_command_names) / sizeof(_command_names[0]))
+
+int main(int argc, char** argv) {
+    int repeat = 100;
+    const char* path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) repeat = atoi(argv[++i]);
+        else if (argv[i][0] != '-' && !path) path = argv[i];
+        else {
+            path = NULL;
+            break;
+        }
+    }
+    if (!path) {
+        fprintf(stderr, "usage: %s [-n repeat] capture\n", argv[0]);
+        return 1;
+    }
+    if (repeat < 1) repeat = 1;
+
+    // note: no assets needed (dither tables are part of the capture)
+    PlaydateAPI* pd = pd_stub_init();
+    lib3d_register(pd);
+
+    int size;
+    uint8_t* data = read_file(path, &size);
+    CaptureReplay replay;
+    if (!data || !capture_open(&replay, data, size)) {
+        fprintf(stderr, "invalid capture: %s\n", path);
+        return 1;
+    }
+
+    // stats
+    const int frames = replay.header.frames;
+    int counts[COMMAND_TYPES] = { 0 };
+    for (int k = 0; k < frames; k++) {
+        const CaptureFrame* frame = (const CaptureFrame*)replay.frames[k];
+        const uint8_t* p = replay.frames[k] + sizeof(CaptureFrame) + LCD_ROWSIZE * LCD_ROWS;
+        for (int i = 0; i < frame->n; i++) {
+            const CaptureCommand* cmd = (const CaptureCommand*)p;
+            if (cmd->type < COMMAND_TYPES) counts[cmd->type]++;
+            p += sizeof(CaptureCommand) + cmd->n * sizeof(Point3du);
+        }
+    }
+    printf("capture: %s frames: %i\n", path, frames);
+    for (int i = 1; i < (int)COMMAND_TYPES; i++) {
+        if (counts[i]) printf("  %s: %i (%.1f/frame)\n", _command_names[i], counts[i], (float)counts[i] / (frames ? frames : 1));
+    }
+
+    // line commands are drawn by the SDK into the frame buffer
+    uint8_t* bitmap = pd->graphics->getFrame();
+    double total = 0, min_frame = DBL_MAX, max_frame = 0;
+    int failed = 0;
+    for (int r = 0; r < repeat; r++) {
+        for (int k = 0; k < frames; k++) {
+            memcpy(bitmap, capture_get_background(&replay, k), LCD_ROWSIZE * LCD_ROWS);
+            const double t0 = pd_stub_time();
+            capture_draw_frame(&replay, k, bitmap);
+            const double t = pd_stub_time() - t0;
+            total += t;
+            if (t < min_frame) min_frame = t;
+            if (t > max_frame) max_frame = t;
+            if (r == 0 && capture_hash(bitmap) != ((const CaptureFrame*)replay.frames[k])->hash) {
+                fprintf(stderr, "frame %i: output does not match capture\n", k);
+                failed = 1;
+            }
+        }
+    }
+    const int n = repeat * (frames ? frames : 1);
+    printf("repeat: %i frame avg: %.3fms min: %.3fms max: %.3fms (%.0f frames/s)\n", repeat, 1000.0 * total / n, 1000.0 * min_frame, 1000.0 * max_frame, n / total);
+
+    capture_close(&replay);
+    lib3d_free(data);
+    return failed;
+}
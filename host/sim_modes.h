@@ -0,0 +1,31 @@
+//
+//  sim_modes.h
+//  host
+//
+//  Course & player parameters of the lua menu panels (play_state).
+//
+
+#ifndef sim_modes_h
+#define sim_modes_h
+
+#include "ground.h"
+#include "sim.h"
+
+typedef struct {
+    const char* name;
+    GroundParams ground;
+    SimParams sim;
+} SimMode;
+
+static const SimMode _sim_modes[] = {
+    { "Marmottes",
+        { .slope = 1.5f, .twist = 2.5f, .num_tracks = 2, .tight_mode = 0, .props_rate = 0.90f, .track_type = 0, .min_cooldown = 30, .max_cooldown = 30 * 2 },
+        { .hp = 3 } },
+    // note: daily runs
+    { "Biquettes",
+        { .slope = 2.f, .twist = 4.f, .num_tracks = 1, .tight_mode = 1, .props_rate = 1.f, .track_type = 1, .min_cooldown = 2, .max_cooldown = 6 },
+        { .hp = 1, .min_boost = 0.f, .max_boost = 1.f, .boost_t = 180.f } }
+};
+#define SIM_MODES (int)(sizeof(_sim_modes) / sizeof(SimMode))
+
+#endif
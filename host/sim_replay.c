@@ -0,0 +1,162 @@
+//
+//  sim_replay.c
+//  host
+//
+//  Replays a recorded input stream against a course seed (no rendering)
+//  and prints the final distance, coins and tricks.
+//
+//  inputs: text file, one frame per line: <crank change> <buttons>
+//  or recording (-f, course & player parameters from recording)
+//  (no input file: synthetic inputs, see -g)
+//
+//  usage: sim_replay [-s seed | -d yyyy/mm/dd] [-m mode] [-i inputs | -f recording] [-g frames] [-r repeat]
+//
+
+#include <stdio.h>
+#include "pd_stub.h"
+#include "luaglue.h"
+#include "ground.h"
+#include "rand_r.h"
+#include "sim.h"
+#include "sim_modes.h"
+#include "record.h"
+#include "realloc.h"
+
+static SimInput* read_inputs(const char* path, int* n) {
+    FILE* f = fopen(path, "r");
+    if (!f) return NULL;
+    int size = 1024;
+    SimInput* inputs = malloc(size * sizeof(SimInput));
+    *n = 0;
+    SimInput input;
+    while (fscanf(f, "%f %i", &input.crank, &input.buttons) == 2) {
+        if (*n == size) {
+            size *= 2;
+            inputs = realloc(inputs, size * sizeof(SimInput));
+        }
+        inputs[(*n)++] = input;
+    }
+    fclose(f);
+    return inputs;
+}
+
+// xorshift (independent from lib3d generators)
+static uint32_t _state = 0x12345678;
+static float next_float() {
+    _state ^= _state << 13;
+    _state ^= _state >> 17;
+    _state ^= _state << 5;
+    return (_state >> 8) / 16777216.f;
+}
+
+// crank sweeps + random jumps
+static SimInput* make_inputs(const int n) {
+    SimInput* inputs = malloc(n * sizeof(SimInput));
+    float crank = 0.f;
+    for (int k = 0; k < n; k++) {
+        crank = 0.9f * crank + 4.f * (next_float() - 0.5f);
+        inputs[k] = (SimInput){ .crank = crank, .buttons = next_float() < 0.02f ? SIM_BUTTON_JUMP : 0 };
+    }
+    return inputs;
+}
+
+// decode recording (overrides mode & seed)
+static SimInput* read_recording(const char* path, int* n, SimMode* mode) {
+    int size;
+    uint8_t* data = record_load(path, &size);
+    if (!data) return NULL;
+    InputReplay replay;
+    if (!replay_start(&replay, data, size)) {
+        lib3d_free(data);
+        return NULL;
+    }
+    mode->name = "recording";
+    mode->ground = replay.header.ground;
+    mode->sim = replay.header.sim;
+    SimInput* inputs = malloc((replay.header.frames + 1) * sizeof(SimInput));
+    *n = 0;
+    while (replay_next(&replay, &inputs[*n])) (*n)++;
+    lib3d_free(data);
+    return inputs;
+}
+
+static void run(GroundContext* ground, TrackPatterns* patterns, const SimMode* mode, const SimInput* inputs, const int n, SimPlayer* plyr) {
+    make_ground(ground, mode->ground, patterns);
+    sim_start(ground, &mode->sim, plyr);
+    for (int k = 0; k < n && !plyr->dead; k++) {
+        sim_step(ground, plyr, &inputs[k]);
+    }
+}
+
+int main(int argc, char** argv) {
+    int seed = 0;
+    int mode = 1;
+    int frames = 3000;
+    int repeat = 1;
+    const char* inputs_path = NULL;
+    const char* recording_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-s") && i + 1 < argc) seed = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-d") && i + 1 < argc) seed = (int)dek_hash(argv[++i]);
+        else if (!strcmp(argv[i], "-m") && i + 1 < argc) mode = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-i") && i + 1 < argc) inputs_path = argv[++i];
+        else if (!strcmp(argv[i], "-f") && i + 1 < argc) recording_path = argv[++i];
+        else if (!strcmp(argv[i], "-g") && i + 1 < argc) frames = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-r") && i + 1 < argc) repeat = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [-s seed | -d yyyy/mm/dd] [-m mode] [-i inputs | -f recording] [-g frames] [-r repeat]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (mode < 0 || mode >= SIM_MODES) {
+        fprintf(stderr, "invalid mode: %i (0-%i)\n", mode, SIM_MODES - 1);
+        return 1;
+    }
+    if (repeat < 1) repeat = 1;
+
+    PlaydateAPI* pd = pd_stub_init();
+    lib3d_register(pd);
+
+    SimMode sim_mode = _sim_modes[mode];
+    sim_mode.ground.r_seed = seed;
+    int n = frames;
+    SimInput* inputs =
+        recording_path ? read_recording(recording_path, &n, &sim_mode) :
+        inputs_path ? read_inputs(inputs_path, &n) :
+        make_inputs(frames);
+    if (!inputs) {
+        fprintf(stderr, "unable to read: %s\n", recording_path ? recording_path : inputs_path);
+        return 1;
+    }
+
+    // slices generated when needed
+    set_generation_budget(0);
+    while (ground_load_assets_async());
+
+    GroundContext* ground = create_ground_context();
+    TrackPatterns* patterns = malloc(sizeof(TrackPatterns));
+    SimPlayer plyr, ref;
+
+    int failed = 0;
+    int steps = 0;
+    const double t0 = pd_stub_time();
+    for (int r = 0; r < repeat; r++) {
+        run(ground, patterns, &sim_mode, inputs, n, &plyr);
+        steps += plyr.frame;
+        if (r == 0) ref = plyr;
+        else if (plyr.frame != ref.frame || plyr.distance != ref.distance || plyr.coins != ref.coins || plyr.tricks != ref.tricks) {
+            if (!failed) fprintf(stderr, "replay mismatch at run: %i\n", r);
+            failed = 1;
+        }
+    }
+    const double t = pd_stub_time() - t0;
+
+    printf("mode: %s seed: %i inputs: %i\n", sim_mode.name, sim_mode.ground.r_seed, n);
+    printf("distance: %i coins: %i tricks: %i frames: %i%s\n", (int)ref.distance, ref.coins, ref.tricks, ref.frame, ref.dead ? " (dead)" : "");
+    printf("replays: %i avg: %.3fms (%.0f replays/s, %.0f frames/s)\n", repeat, 1000.0 * t / repeat, repeat / t, steps / t);
+
+    free(patterns);
+    free(inputs);
+    destroy_ground_context(ground);
+    return failed;
+}
@@ -0,0 +1,89 @@
+//
+//  sort_bench.c
+//  host
+//
+//  Compares qsort vs. radix_sort on drawable sort keys at realistic
+//  drawable counts, and checks both produce the same order.
+//
+//  usage: sort_bench [-i iterations]
+//
+
+#include <stdio.h>
+#include "pd_stub.h"
+#include "drawables.h"
+#include "ground_limits.h"
+
+// same comparator as draw_drawables used to
+static int cmp_sortable(const void* a, const void* b) {
+    const uint32_t x = ((Sortable*)a)->v;
+    const uint32_t y = ((Sortable*)b)->v;
+    return x > y ? -1 : x == y ? 0 : 1;
+}
+
+// xorshift (independent from lib3d generators)
+static uint32_t _state = 0x12345678;
+static float next_float() {
+    _state ^= _state << 13;
+    _state ^= _state >> 17;
+    _state ^= _state << 5;
+    return (_state >> 8) / 16777216.f;
+}
+
+// keys of faces evenly spread over the view wedge (+ near clutter)
+static void make_keys(Sortable* out, const int n) {
+    const float zmax = (float)(GROUND_CELL_SIZE * MAX_TILE_DIST);
+    for (int i = 0; i < n; i++) {
+        float z = zmax * sqrtf(next_float());
+        // some duplicated depths (props faces share a key)
+        if (i > 0 && next_float() < 0.1f) z = out[i - 1].key / 256.0f;
+        out[i] = (Sortable){ .i = (uint16_t)i, .key = (uint16_t)(z * 256.0f) };
+    }
+}
+
+int main(int argc, char** argv) {
+    int iterations = 2000;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-i") && i + 1 < argc) iterations = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [-i iterations]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (iterations < 1) iterations = 1;
+
+    static Sortable keys[MAX_DRAWABLES];
+    static Sortable a[MAX_DRAWABLES];
+    static Sortable b[MAX_DRAWABLES];
+    static Sortable tmp[MAX_DRAWABLES];
+    const int counts[] = { 128, 256, 512, 1024, MAX_DRAWABLES - 1 };
+
+    int failed = 0;
+    printf("%-6s %12s %12s %8s\n", "n", "qsort us", "radix us", "speedup");
+    for (int c = 0; c < sizeof(counts) / sizeof(int); c++) {
+        const int n = counts[c];
+        double qsort_time = 0, radix_time = 0;
+        for (int k = 0; k < iterations; k++) {
+            make_keys(keys, n);
+
+            memcpy(a, keys, n * sizeof(Sortable));
+            double t0 = pd_stub_time();
+            qsort(a, (size_t)n, sizeof(Sortable), cmp_sortable);
+            qsort_time += pd_stub_time() - t0;
+
+            memcpy(b, keys, n * sizeof(Sortable));
+            t0 = pd_stub_time();
+            radix_sort(b, tmp, n);
+            radix_time += pd_stub_time() - t0;
+
+            if (memcmp(a, b, n * sizeof(Sortable))) {
+                if (!failed) fprintf(stderr, "order mismatch at n: %i iteration: %i\n", n, k);
+                failed = 1;
+            }
+        }
+        qsort_time *= 1e6 / iterations;
+        radix_time *= 1e6 / iterations;
+        printf("%-6i %12.2f %12.2f %7.2fx\n", n, qsort_time, radix_time, qsort_time / radix_time);
+    }
+
+    return failed;
+}
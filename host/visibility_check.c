@@ -0,0 +1,75 @@
+//
+//  visibility_check.c
+//  host
+//
+//  Checks that the view wedge tiles (collect_tiles_wedge) are a superset
+//  of the ray casted tiles (collect_tiles_raycast) over random camera poses.
+//
+//  usage: visibility_check [-n poses] [-s seed]
+//
+
+#include <stdio.h>
+#include "pd_stub.h"
+#include "visibility.h"
+
+static uint32_t _state = 0x2545F491;
+static float next_float() {
+    _state ^= _state << 13;
+    _state ^= _state >> 17;
+    _state ^= _state << 5;
+    return (_state >> 8) / 16777216.f;
+}
+
+static int count_bits(uint32_t v) {
+    int n = 0;
+    for (; v; v &= v - 1) n++;
+    return n;
+}
+
+int main(int argc, char** argv) {
+    int poses = 10000;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) poses = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc) _state = (uint32_t)atoi(argv[++i]) | 1;
+        else {
+            fprintf(stderr, "usage: %s [-n poses] [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    PlaydateAPI* pd = pd_stub_init();
+    visibility_init(pd);
+
+    int failures = 0;
+    long raycast_tiles = 0, wedge_tiles = 0;
+    for (int k = 0; k < poses; k++) {
+        // anywhere on the ground (player stays away from borders)
+        const Point3d pos = { .v = {
+            GROUND_CELL_SIZE * (1.f + (GROUND_WIDTH - 2) * next_float()),
+            0.f,
+            GROUND_CELL_SIZE * (1.f + (GROUND_HEIGHT - 2) * next_float()) } };
+        const float angle = 2.f * PI * (next_float() - 0.5f);
+
+        uint32_t raycast[GROUND_HEIGHT] = { 0 };
+        uint32_t wedge[GROUND_HEIGHT] = { 0 };
+        collect_tiles_raycast(raycast, pos, angle);
+        collect_tiles_wedge(wedge, pos, angle);
+
+        int missed = 0;
+        for (int j = 0; j < GROUND_HEIGHT; j++) {
+            missed += count_bits(raycast[j] & ~wedge[j]);
+            raycast_tiles += count_bits(raycast[j]);
+            wedge_tiles += count_bits(wedge[j]);
+        }
+        if (missed) {
+            if (failures < 10) {
+                fprintf(stderr, "pose %i: pos: %f,%f angle: %f - %i tile(s) missing\n", k, pos.x, pos.z, angle, missed);
+            }
+            failures++;
+        }
+    }
+
+    printf("poses: %i failures: %i\n", poses, failures);
+    printf("avg. tiles raycast: %.1f wedge: %.1f\n", (double)raycast_tiles / poses, (double)wedge_tiles / poses);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,101 @@
+#include "arena.h"
+#include "realloc.h"
+
+static PlaydateAPI* pd;
+
+uint8_t* _arena_data = NULL;
+
+static struct {
+    int capacity;
+    int size;
+    int reserved;
+    int peak;
+    // frame in flight?
+    int active;
+    // exhaustion already reported for this frame?
+    int failed;
+} _arena;
+
+int arena_set_capacity(int capacity) {
+    if (_arena.active) {
+        pd->system->logToConsole("Frame arena cannot be resized during a frame");
+        return 0;
+    }
+    if (capacity > ARENA_MAX_CAPACITY) {
+        pd->system->logToConsole("Frame arena capacity clamped: %i (max: %i)", capacity, ARENA_MAX_CAPACITY);
+        capacity = ARENA_MAX_CAPACITY;
+    }
+    if (capacity < ARENA_MIN_CAPACITY) {
+        pd->system->logToConsole("Frame arena capacity clamped: %i (min: %i)", capacity, ARENA_MIN_CAPACITY);
+        capacity = ARENA_MIN_CAPACITY;
+    }
+    uint8_t* data = lib3d_realloc(_arena_data, capacity);
+    if (!data) {
+        pd->system->logToConsole("Frame arena: unable to allocate %i bytes", capacity);
+        return 0;
+    }
+    _arena_data = data;
+    _arena.capacity = capacity;
+    _arena.size = 0;
+    _arena.reserved = 0;
+    return 1;
+}
+
+// note: reserved bytes are accounted as used
+static int arena_fits(const int next) {
+    const int total = next + _arena.reserved;
+    if (total > _arena.peak) _arena.peak = total;
+    if (total > _arena.capacity) {
+        if (!_arena.failed) {
+            pd->system->logToConsole("Frame arena exhausted: %i/%i bytes", total, _arena.capacity);
+            _arena.failed = 1;
+        }
+        return 0;
+    }
+    return 1;
+}
+
+void* arena_alloc(const int size) {
+    const int offset = _arena.size;
+    const int next = offset + ((size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1));
+    if (!arena_fits(next)) return NULL;
+    _arena.size = next;
+    return _arena_data + offset;
+}
+
+int arena_reserve(const int size) {
+    if (!arena_fits(_arena.size + size)) return 0;
+    _arena.reserved += size;
+    return 1;
+}
+
+void arena_release(const int size) {
+    _arena.reserved -= size;
+    if (_arena.reserved < 0) _arena.reserved = 0;
+}
+
+void arena_reset() {
+    _arena.size = 0;
+    _arena.reserved = 0;
+    _arena.active = 1;
+    _arena.failed = 0;
+}
+
+void arena_end_frame() {
+    _arena.active = 0;
+}
+
+void arena_get_stats(ArenaStats* out) {
+    out->capacity = _arena.capacity;
+    out->used = _arena.size;
+    out->peak = _arena.peak;
+}
+
+void arena_reset_peak() {
+    _arena.peak = _arena.size;
+}
+
+void arena_init(PlaydateAPI* playdate) {
+    pd = playdate;
+    if (!_arena_data) arena_set_capacity(ARENA_DEFAULT_CAPACITY);
+}
@@ -0,0 +1,50 @@
+#ifndef _arena_h
+#define _arena_h
+
+#include <pd_api.h>
+
+// per frame linear allocator for transient render data (drawables, vertices, sort buffers, ...)
+// bump allocation, everything is released at once by arena_reset (see reset_drawables)
+// allocations are 8 bytes aligned and can be referenced by a 16-bit handle (offset / 8)
+#define ARENA_ALIGN 8
+// largest capacity addressable by handles
+#define ARENA_MAX_CAPACITY (65536 * ARENA_ALIGN)
+#define ARENA_DEFAULT_CAPACITY (128 * 1024)
+// smallest capacity accepted by arena_set_capacity
+#define ARENA_MIN_CAPACITY (16 * 1024)
+
+// arena storage (handle base)
+extern uint8_t* _arena_data;
+
+#define ARENA_HANDLE(ptr) ((uint16_t)(((const uint8_t*)(ptr) - _arena_data) / ARENA_ALIGN))
+#define ARENA_PTR(handle) ((void*)(_arena_data + (handle) * ARENA_ALIGN))
+
+typedef struct {
+    // bytes
+    int capacity;
+    // in use since last reset
+    int used;
+    // high water mark since last arena_reset_peak (includes failed allocations)
+    int peak;
+} ArenaStats;
+
+// (re)allocates arena storage (releases all allocations)
+// capacity is clamped to [ARENA_MIN_CAPACITY, ARENA_MAX_CAPACITY]
+// returns 0 if a frame is in flight (between arena_reset and arena_end_frame) or allocation failed
+int arena_set_capacity(int capacity);
+// size bytes, NULL if arena is exhausted (reserved bytes included)
+void* arena_alloc(const int size);
+// set size bytes aside for later allocations, 0 if arena is exhausted
+int arena_reserve(const int size);
+// make reserved bytes available to arena_alloc
+void arena_release(const int size);
+// release all allocations & reservations (starts a frame)
+void arena_reset();
+// frame done, arena can be resized
+void arena_end_frame();
+void arena_get_stats(ArenaStats* out);
+void arena_reset_peak();
+
+void arena_init(PlaydateAPI* playdate);
+
+#endif
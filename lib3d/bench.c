@@ -0,0 +1,200 @@
+#include <float.h>
+#include "bench.h"
+#include "particles.h"
+#include "profile.h"
+
+static PlaydateAPI* pd;
+
+// timed stages
+#define BENCH_STAGE_UPDATE 0
+#define BENCH_STAGE_RENDER 1
+#define BENCH_STAGE_COUNT 2
+
+static const char* _stage_names[BENCH_STAGE_COUNT] = { "update", "render" };
+
+typedef struct {
+    float total;
+    float min;
+    float max;
+} BenchTiming;
+
+static struct {
+    int active;
+    int summary_frames;
+    // frames in current summary
+    int n;
+    GroundContext* ground;
+    BenchFlight flight;
+    BenchTiming stages[BENCH_STAGE_COUNT];
+#ifdef LIB3D_PROFILE
+    // render stages total (milliseconds)
+    float profile_stages[PROFILE_STAGE_COUNT];
+#endif
+    TrackPatterns patterns;
+} _bench;
+
+void get_bench_params(int seed, int track_type, GroundParams* out) {
+    *out = (GroundParams){
+        .slope = 2.f,
+        .twist = 4.f,
+        .num_tracks = 1,
+        .tight_mode = 0,
+        .props_rate = 0.87f,
+        .track_type = track_type,
+        .min_cooldown = 8,
+        .max_cooldown = 12,
+        .r_seed = seed
+    };
+}
+
+void start_bench_flight(const GroundContext* ground, BenchFlight* flight) {
+    flight->frame = 0;
+    flight->up = (Point3d){ .v = { 0.f, 1.f, 0.f } };
+    get_start_pos(ground, &flight->pos);
+}
+
+void update_bench_flight(GroundContext* ground, BenchFlight* flight, Point3d* cam_pos, float* cam_tau_angle, Mat4 cam_m) {
+    const int k = flight->frame++;
+    Point3d* pos = &flight->pos;
+
+    // downhill, slaloming around the track center
+    const float tau_angle = 0.08f * sinf(k / 45.f);
+    const float speed = 0.9f + 0.4f * sinf(k / 120.f);
+    pos->x += speed * sinf(detauify(tau_angle));
+    pos->z += speed * cosf(detauify(tau_angle));
+    if (pos->x < 3.f * GROUND_CELL_SIZE) pos->x = 3.f * GROUND_CELL_SIZE;
+    if (pos->x > (GROUND_WIDTH - 4) * GROUND_CELL_SIZE) pos->x = (GROUND_WIDTH - 4) * GROUND_CELL_SIZE;
+
+    int slice_id;
+    TrackPattern pattern;
+    Point3d offset;
+    update_ground(ground, *pos, &slice_id, &pattern, &offset);
+    for (int i = 0; i < 3; i++) pos->v[i] += offset.v[i];
+    update_particles(offset);
+
+    // follow ground
+    Point3d n;
+    float y;
+    if (get_face(ground, *pos, &n, &y)) {
+        pos->y = y;
+        v_lerp(flight->up, n, 0.1f, &flight->up);
+        v_normz(&flight->up);
+    }
+
+    // camera (same as lua cam:track)
+    const Point3d up = flight->up;
+    const float angle = detauify(tau_angle);
+    Point3d fwd = { .v = { sinf(angle), 0.f, cosf(angle) } };
+    Point3d right;
+    v_cross(up, fwd, &right);
+    v_normz(&right);
+    v_cross(right, up, &fwd);
+
+    // 1.2m above ground
+    *cam_pos = *pos;
+    cam_pos->y += 0.5f;
+    for (int i = 0; i < 3; i++) cam_pos->v[i] += 1.2f * up.v[i];
+    *cam_tau_angle = tau_angle;
+
+    // inverse view matrix
+    const Mat4 r = {
+        right.x, up.x, fwd.x, 0.f,
+        right.y, up.y, fwd.y, 0.f,
+        right.z, up.z, fwd.z, 0.f,
+        0.f, 0.f, 0.f, 1.f };
+    m_x_m(r, (Mat4) {
+        1.f, 0.f, 0.f, 0.f,
+        0.f, 1.f, 0.f, 0.f,
+        0.f, 0.f, 1.f, 0.f,
+        -cam_pos->x, -cam_pos->y, -cam_pos->z, 1.f
+    }, cam_m);
+}
+
+static void reset_timings() {
+    _bench.n = 0;
+    for (int i = 0; i < BENCH_STAGE_COUNT; i++) {
+        _bench.stages[i] = (BenchTiming){ .total = 0.f, .min = FLT_MAX, .max = 0.f };
+    }
+#ifdef LIB3D_PROFILE
+    for (int i = 0; i < PROFILE_STAGE_COUNT; i++) {
+        _bench.profile_stages[i] = 0.f;
+    }
+#endif
+}
+
+static void add_timing(const int stage, const float t) {
+    BenchTiming* timing = &_bench.stages[stage];
+    timing->total += t;
+    if (t < timing->min) timing->min = t;
+    if (t > timing->max) timing->max = t;
+}
+
+void start_bench(int summary_frames) {
+    // make sure all assets are there
+    while (ground_load_assets_async());
+
+    if (!_bench.ground) _bench.ground = create_ground_context();
+
+    GroundParams params;
+    get_bench_params(BENCH_SEED, 0, &params);
+    const float t0 = pd->system->getElapsedTime();
+    make_ground(_bench.ground, params, &_bench.patterns);
+    const float t1 = pd->system->getElapsedTime();
+
+    start_bench_flight(_bench.ground, &_bench.flight);
+    _bench.summary_frames = summary_frames > 0 ? summary_frames : BENCH_SUMMARY_FRAMES;
+    _bench.active = 1;
+    reset_timings();
+
+    pd->system->logToConsole("bench: seed %i make_ground: %.3fms", BENCH_SEED, (double)(1000.f * (t1 - t0)));
+}
+
+void update_bench(uint8_t* bitmap) {
+    if (!_bench.active) {
+        pd->system->error("Benchmark not started - call bench_init first");
+        return;
+    }
+
+    Point3d cam_pos;
+    float cam_tau_angle;
+    Mat4 cam_m;
+    const float t0 = pd->system->getElapsedTime();
+    update_bench_flight(_bench.ground, &_bench.flight, &cam_pos, &cam_tau_angle, cam_m);
+    const float t1 = pd->system->getElapsedTime();
+    render_ground(_bench.ground, cam_pos, cam_tau_angle, cam_m, 0, bitmap);
+    const float t2 = pd->system->getElapsedTime();
+
+    add_timing(BENCH_STAGE_UPDATE, 1000.f * (t1 - t0));
+    add_timing(BENCH_STAGE_RENDER, 1000.f * (t2 - t1));
+#ifdef LIB3D_PROFILE
+    FrameStatsSummary stats;
+    profile_get_stats(1, &stats);
+    for (int i = 0; i < PROFILE_STAGE_COUNT; i++) {
+        _bench.profile_stages[i] += stats.stages[i];
+    }
+#endif
+
+    if (++_bench.n >= _bench.summary_frames) {
+        float total = 0.f;
+        pd->system->logToConsole("bench: frames %i-%i", _bench.flight.frame - _bench.n, _bench.flight.frame - 1);
+        for (int i = 0; i < BENCH_STAGE_COUNT; i++) {
+            const BenchTiming* timing = &_bench.stages[i];
+            total += timing->total;
+            pd->system->logToConsole("  %-8s avg: %.3fms min: %.3fms max: %.3fms", _stage_names[i], (double)(timing->total / _bench.n), (double)timing->min, (double)timing->max);
+        }
+        pd->system->logToConsole("  %-8s avg: %.3fms", "frame", (double)(total / _bench.n));
+#ifdef LIB3D_PROFILE
+        pd->system->logToConsole("  render stages:");
+        for (int i = 0; i < PROFILE_STAGE_COUNT; i++) {
+            pd->system->logToConsole("    %-10s avg: %.3fms", _profile_stage_names[i], (double)(_bench.profile_stages[i] / _bench.n));
+        }
+#endif
+        reset_timings();
+    }
+}
+
+void bench_init(PlaydateAPI* playdate) {
+    pd = playdate;
+    _bench.active = 0;
+    _bench.ground = NULL;
+}
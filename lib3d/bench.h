@@ -0,0 +1,42 @@
+#ifndef _bench_h
+#define _bench_h
+
+#include <pd_api.h>
+#include "3dmath.h"
+#include "ground.h"
+
+// fixed benchmark seed
+#define BENCH_SEED 12345
+// number of frames between 2 summaries
+#define BENCH_SUMMARY_FRAMES 100
+
+// deterministic camera flight over the ground
+typedef struct {
+    int frame;
+    // player position (ground space)
+    Point3d pos;
+    // smoothed ground normal
+    Point3d up;
+} BenchFlight;
+
+// fixed ground parameters
+void get_bench_params(int seed, int track_type, GroundParams* out);
+
+// start flight at ground start position (to be called after make_ground)
+void start_bench_flight(const GroundContext* ground, BenchFlight* flight);
+
+// move flight by one frame (includes ground & particles update) and returns camera
+void update_bench_flight(GroundContext* ground, BenchFlight* flight, Point3d* cam_pos, float* cam_tau_angle, Mat4 cam_m);
+
+// (re)create benchmark ground and reset timings
+// note: benchmark uses its own ground context
+void start_bench(int summary_frames);
+
+// run one benchmark frame, logs a summary every summary_frames
+// (includes render stages when LIB3D_PROFILE is defined)
+void update_bench(uint8_t* bitmap);
+
+// init module
+void bench_init(PlaydateAPI* playdate);
+
+#endif
@@ -0,0 +1,279 @@
+#include "capture.h"
+#include "gfx.h"
+#include "realloc.h"
+
+static PlaydateAPI* pd;
+
+static const char _magic[4] = { 'M', 'W', 'R', 'C' };
+
+#define CAPTURE_NO_KEY 0xffffffff
+
+int _capture_active = 0;
+
+static struct {
+    const uint8_t* ptr[CAPTURE_MAX_TABLES];
+    int size[CAPTURE_MAX_TABLES];
+    int n;
+} _tables;
+
+static struct {
+    char path[256];
+    // frames left to capture
+    int pending;
+    int frames;
+    // start of current frame
+    int frame;
+    int commands;
+    // S-buffer key: last set vs. last written
+    uint32_t key;
+    uint32_t written_key;
+    int size;
+    int capacity;
+    uint8_t* data;
+} _capture;
+
+static uint8_t* push_bytes(const int n) {
+    if (_capture.size + n > _capture.capacity) {
+        while (_capture.size + n > _capture.capacity)
+            _capture.capacity = _capture.capacity ? 2 * _capture.capacity : 64 * 1024;
+        _capture.data = lib3d_realloc(_capture.data, _capture.capacity);
+    }
+    uint8_t* p = _capture.data + _capture.size;
+    _capture.size += n;
+    return p;
+}
+
+static void push_command(const int type, const int n, const int table, const int offset, const uint32_t value) {
+    CaptureCommand* cmd = (CaptureCommand*)push_bytes(sizeof(CaptureCommand));
+    cmd->type = (uint8_t)type;
+    cmd->n = (uint8_t)n;
+    cmd->table = (int16_t)table;
+    cmd->offset = offset;
+    cmd->value = value;
+    _capture.commands++;
+}
+
+// lazy S-buffer key (only for drawables actually issuing commands)
+static void push_key() {
+    if (_capture.key != _capture.written_key) {
+        push_command(CAPTURE_SBUFFER_KEY, 0, -1, 0, _capture.key);
+        _capture.written_key = _capture.key;
+    }
+}
+
+void capture_register_table(const void* table, const int size) {
+    for (int i = 0; i < _tables.n; i++) {
+        if (_tables.ptr[i] == table) return;
+    }
+    if (_tables.n == CAPTURE_MAX_TABLES) {
+        pd->system->error("Too many capture tables: %i", _tables.n);
+        return;
+    }
+    _tables.ptr[_tables.n] = (const uint8_t*)table;
+    _tables.size[_tables.n] = size;
+    _tables.n++;
+}
+
+void capture_frames(const char* path, const int frames) {
+    strncpy(_capture.path, path, sizeof(_capture.path) - 1);
+    _capture.path[sizeof(_capture.path) - 1] = '\0';
+    _capture.pending = frames;
+    _capture.frames = 0;
+    _capture.size = 0;
+}
+
+int capture_pending() {
+    return _capture.pending;
+}
+
+static void save_capture() {
+    SDFile* file = pd->file->open(_capture.path, kFileWrite);
+    if (!file) {
+        pd->system->logToConsole("Unable to create: %s (%s)", _capture.path, pd->file->geterr());
+        return;
+    }
+    CaptureHeader header = { .version = CAPTURE_VERSION, .frames = _capture.frames, .tables = _tables.n };
+    memcpy(header.magic, _magic, sizeof(_magic));
+    int res = pd->file->write(file, &header, sizeof(CaptureHeader)) == sizeof(CaptureHeader);
+    for (int i = 0; i < _tables.n && res; i++) {
+        res = pd->file->write(file, &_tables.size[i], sizeof(int)) == sizeof(int) &&
+            pd->file->write(file, _tables.ptr[i], _tables.size[i]) == _tables.size[i];
+    }
+    if (res) res = pd->file->write(file, _capture.data, _capture.size) == _capture.size;
+    pd->file->close(file);
+    if (res)
+        pd->system->logToConsole("Captured: %i frames (%i bytes) to: %s", _capture.frames, _capture.size, _capture.path);
+    else
+        pd->system->logToConsole("Unable to write: %s (%s)", _capture.path, pd->file->geterr());
+}
+
+void capture_frame_begin(const uint8_t* bitmap) {
+    if (_capture.pending <= 0) return;
+
+    _capture.frame = _capture.size;
+    _capture.commands = 0;
+    _capture.key = _capture.written_key = CAPTURE_NO_KEY;
+    push_bytes(sizeof(CaptureFrame));
+    memcpy(push_bytes(LCD_ROWSIZE * LCD_ROWS), bitmap, LCD_ROWSIZE * LCD_ROWS);
+    _capture_active = 1;
+}
+
+void capture_frame_end(const uint8_t* bitmap) {
+    if (!_capture_active) return;
+    _capture_active = 0;
+
+    CaptureFrame* frame = (CaptureFrame*)(_capture.data + _capture.frame);
+    frame->n = _capture.commands;
+    frame->size = _capture.size - _capture.frame - sizeof(CaptureFrame) - LCD_ROWSIZE * LCD_ROWS;
+    frame->hash = capture_hash(bitmap);
+    _capture.frames++;
+
+    if (--_capture.pending == 0) {
+        save_capture();
+        lib3d_free(_capture.data);
+        _capture.data = NULL;
+        _capture.size = _capture.capacity = 0;
+    }
+}
+
+static int find_table(const void* ptr, int* offset) {
+    const uint8_t* p = (const uint8_t*)ptr;
+    for (int i = 0; i < _tables.n; i++) {
+        if (p >= _tables.ptr[i] && p < _tables.ptr[i] + _tables.size[i]) {
+            *offset = (int)(p - _tables.ptr[i]);
+            return i;
+        }
+    }
+    *offset = 0;
+    return -1;
+}
+
+uint32_t capture_table_ref(const void* ptr) {
+    int offset;
+    const int t = find_table(ptr, &offset);
+    return t < 0 ? 0xffffffff : ((uint32_t)t << 16) | (uint32_t)offset;
+}
+
+void capture_fill(const int type, const Point3du* verts, const int n, const void* table, const uint32_t value) {
+    int offset;
+    const int t = find_table(table, &offset);
+    push_key();
+    push_command(type, n, t, offset, value);
+    memcpy(push_bytes(n * sizeof(Point3du)), verts, n * sizeof(Point3du));
+}
+
+void capture_sbuffer(const int type, const uint32_t key) {
+    if (type == CAPTURE_SBUFFER_KEY) {
+        _capture.key = key;
+        return;
+    }
+    push_command(type, 0, -1, 0, 0);
+    _capture.written_key = CAPTURE_NO_KEY;
+}
+
+void capture_line(const int type, const int x0, const int y0, const int x1, const int y1) {
+    push_key();
+    push_command(type, 2, -1, 0, 0);
+    Point3du* pts = (Point3du*)push_bytes(2 * sizeof(Point3du));
+    memset(pts, 0, 2 * sizeof(Point3du));
+    pts[0].x = (float)x0, pts[0].y = (float)y0;
+    pts[1].x = (float)x1, pts[1].y = (float)y1;
+}
+
+int capture_open(CaptureReplay* replay, uint8_t* data, const int size) {
+    replay->frames = NULL;
+    if (size < (int)sizeof(CaptureHeader)) return 0;
+    memcpy(&replay->header, data, sizeof(CaptureHeader));
+    if (memcmp(replay->header.magic, _magic, sizeof(_magic)) || replay->header.version != CAPTURE_VERSION) {
+        pd->system->logToConsole("Invalid capture version: %i (expected: %i)", replay->header.version, CAPTURE_VERSION);
+        return 0;
+    }
+    if (replay->header.tables < 0 || replay->header.tables > CAPTURE_MAX_TABLES || replay->header.frames < 0) return 0;
+
+    int pos = sizeof(CaptureHeader);
+    for (int i = 0; i < replay->header.tables; i++) {
+        if (pos + (int)sizeof(int) > size) return 0;
+        memcpy(&replay->sizes[i], data + pos, sizeof(int));
+        pos += sizeof(int);
+        if (replay->sizes[i] < 0 || pos + replay->sizes[i] > size) return 0;
+        replay->tables[i] = data + pos;
+        pos += replay->sizes[i];
+    }
+
+    replay->frames = lib3d_malloc(replay->header.frames * sizeof(uint8_t*));
+    for (int k = 0; k < replay->header.frames; k++) {
+        CaptureFrame frame;
+        if (pos + (int)sizeof(CaptureFrame) > size) break;
+        memcpy(&frame, data + pos, sizeof(CaptureFrame));
+        const int next = pos + sizeof(CaptureFrame) + LCD_ROWSIZE * LCD_ROWS + frame.size;
+        if (frame.size < 0 || next > size) break;
+        replay->frames[k] = data + pos;
+        pos = next;
+    }
+    if (pos != size) {
+        pd->system->logToConsole("Invalid capture size: %i (expected: %i)", size, pos);
+        capture_close(replay);
+        return 0;
+    }
+    return 1;
+}
+
+void capture_close(CaptureReplay* replay) {
+    lib3d_free(replay->frames);
+    replay->frames = NULL;
+}
+
+const uint8_t* capture_get_background(const CaptureReplay* replay, const int frame) {
+    return replay->frames[frame] + sizeof(CaptureFrame);
+}
+
+void capture_draw_frame(const CaptureReplay* replay, const int frame, uint8_t* bitmap) {
+    const CaptureFrame* header = (const CaptureFrame*)replay->frames[frame];
+    const uint8_t* p = replay->frames[frame] + sizeof(CaptureFrame) + LCD_ROWSIZE * LCD_ROWS;
+    for (int k = 0; k < header->n; k++) {
+        const CaptureCommand* cmd = (const CaptureCommand*)p;
+        const Point3du* pts = (const Point3du*)(p + sizeof(CaptureCommand));
+        p += sizeof(CaptureCommand) + cmd->n * sizeof(Point3du);
+        uint8_t* table = cmd->table >= 0 ? replay->tables[cmd->table] + cmd->offset : NULL;
+        switch (cmd->type) {
+        case CAPTURE_POLYFILL:
+            if (table) polyfill(pts, cmd->n, (uint32_t*)table, (uint32_t*)bitmap);
+            break;
+        case CAPTURE_TEXFILL:
+            if (table) texfill(pts, cmd->n, table, bitmap);
+            break;
+        case CAPTURE_ALPHAFILL:
+            if (table) alphafill(pts, cmd->n, cmd->value, (uint32_t*)table, (uint32_t*)bitmap);
+            break;
+        case CAPTURE_TEXALPHAFILL: {
+            const int t = cmd->value >> 16;
+            if (table && cmd->value != 0xffffffff && t < replay->header.tables)
+                texalphafill(pts, cmd->n, table, (uint32_t*)(replay->tables[t] + (cmd->value & 0xffff)), bitmap);
+            break;
+        }
+        case CAPTURE_SBUFFER_BEGIN: sbuffer_begin(); break;
+        case CAPTURE_SBUFFER_END: sbuffer_end(); break;
+        case CAPTURE_SBUFFER_KEY: sbuffer_set_key((uint16_t)cmd->value); break;
+        case CAPTURE_SBUFFER_LINE:
+            sbuffer_line((int)pts[0].x, (int)pts[0].y, (int)pts[1].x, (int)pts[1].y, bitmap);
+            break;
+        case CAPTURE_LINE:
+            // note: SDK line goes to frame buffer
+            pd->graphics->drawLine((int)pts[0].x, (int)pts[0].y, (int)pts[1].x, (int)pts[1].y, 1, kColorBlack);
+            break;
+        }
+    }
+}
+
+uint32_t capture_hash(const uint8_t* bitmap) {
+    uint32_t h = 0x811c9dc5;
+    for (int i = 0; i < LCD_ROWSIZE * LCD_ROWS; i++) {
+        h ^= bitmap[i];
+        h *= 0x01000193;
+    }
+    return h;
+}
+
+void capture_init(PlaydateAPI* playdate) {
+    pd = playdate;
+}
@@ -0,0 +1,105 @@
+#ifndef _capture_h
+#define _capture_h
+
+#include <pd_api.h>
+#include "3dmath.h"
+
+// raster command capture
+// records the fill calls issued by draw_drawables (screen space polygons, after projection & shading)
+// so that frames can be replayed straight into the rasterizers (no ground/geometry stages)
+//
+// file layout:
+// header
+// tables: per table: int size + table bytes
+// frames: per frame: CaptureFrame + background bitmap (before drawables) + commands
+// command: CaptureCommand + n Point3du
+#define CAPTURE_VERSION 1
+#define CAPTURE_MAX_TABLES 8
+
+// commands
+#define CAPTURE_POLYFILL 1
+#define CAPTURE_TEXFILL 2
+#define CAPTURE_ALPHAFILL 3
+// S-buffer state (value: key)
+#define CAPTURE_SBUFFER_BEGIN 4
+#define CAPTURE_SBUFFER_END 5
+#define CAPTURE_SBUFFER_KEY 6
+// lines (pts: 2 end points)
+#define CAPTURE_SBUFFER_LINE 7
+#define CAPTURE_LINE 8
+// value: alpha table reference (see capture_table_ref)
+#define CAPTURE_TEXALPHAFILL 9
+
+typedef struct {
+    char magic[4];
+    int version;
+    int frames;
+    int tables;
+} CaptureHeader;
+
+typedef struct {
+    // number of commands
+    int n;
+    // size of commands (bytes)
+    int size;
+    // FNV-1a of frame after rasterization
+    uint32_t hash;
+} CaptureFrame;
+
+typedef struct {
+    uint8_t type;
+    uint8_t n;
+    // dither table (-1: none)
+    int16_t table;
+    // offset in dither table (bytes)
+    int offset;
+    // fill color or S-buffer key
+    uint32_t value;
+} CaptureCommand;
+
+// decoded capture
+typedef struct {
+    CaptureHeader header;
+    uint8_t* tables[CAPTURE_MAX_TABLES];
+    int sizes[CAPTURE_MAX_TABLES];
+    // per frame start (CaptureFrame)
+    uint8_t** frames;
+} CaptureReplay;
+
+// true while capturing a frame (fill hooks)
+extern int _capture_active;
+
+// register a dither table referenced by fill calls
+// note: content is copied when capture is saved
+void capture_register_table(const void* table, const int size);
+
+// capture the next frames rendered by draw_drawables and write them to path
+void capture_frames(const char* path, const int frames);
+// captures left to be done
+int capture_pending();
+
+// frame boundaries (called by draw_drawables)
+void capture_frame_begin(const uint8_t* bitmap);
+void capture_frame_end(const uint8_t* bitmap);
+
+// fill hooks (called by gfx functions when capture is active)
+void capture_fill(const int type, const Point3du* verts, const int n, const void* table, const uint32_t value);
+void capture_sbuffer(const int type, const uint32_t key);
+void capture_line(const int type, const int x0, const int y0, const int x1, const int y1);
+// table << 16 | offset of a pointer into a registered table (0xffffffff: not found)
+uint32_t capture_table_ref(const void* ptr);
+
+// index a capture file (data must be kept until capture_close)
+// returns 0 if capture is invalid
+int capture_open(CaptureReplay* replay, uint8_t* data, const int size);
+void capture_close(CaptureReplay* replay);
+// background of frame (bitmap before drawables)
+const uint8_t* capture_get_background(const CaptureReplay* replay, const int frame);
+// replay frame commands into bitmap (background not restored)
+void capture_draw_frame(const CaptureReplay* replay, const int frame, uint8_t* bitmap);
+// FNV-1a of a bitmap
+uint32_t capture_hash(const uint8_t* bitmap);
+
+void capture_init(PlaydateAPI* playdate);
+
+#endif
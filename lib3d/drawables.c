@@ -1,63 +1,219 @@
 #include "drawables.h"
+#include "profile.h"
+#include "gfx.h"
+#include "capture.h"
 
 static PlaydateAPI* pd;
 
 // indexes all things that are going to be drawn
-
-typedef struct {
+// note: drawables are allocated from the frame arena, linked in push order
+static struct {
     int n;
-    // arbitrary limit
-    Drawable all[1024];
-} Drawables;
-
-typedef struct {
-    union {
-        struct {
-            // low bits
-            uint16_t i;
-            // high bits (???)
-            uint16_t key;
-        };
-        uint32_t v;
-    };
-} Sortable;
-
-static Drawables _drawables = {0};
-static Sortable _sortables[MAX_DRAWABLES] = {0};
-
-// compare 2 drawables
-static int cmp_sortable(const void* a, const void* b) {
-    const uint32_t x = ((Sortable*)a)->v;
-    const uint32_t y = ((Sortable*)b)->v;
-    return x > y ? -1 : x == y ? 0 : 1;
+    // sorted vs. ordered drawables
+    int sorted;
+    int ordered;
+    uint16_t first;
+    Drawable* last;
+} _drawables = {0};
+
+// 2 passes LSD radix sort on the 16-bit key
+void radix_sort(Sortable* sortables, Sortable* tmp, const int n) {
+    int lo[256] = {0};
+    int hi[256] = {0};
+
+    // histograms (reversed digits for decreasing order)
+    for (int k = 0; k < n; k++) {
+        const uint16_t key = sortables[k].key;
+        lo[255 - (key & 0xff)]++;
+        hi[255 - (key >> 8)]++;
+    }
+    // prefix sums
+    int lo_sum = 0, hi_sum = 0;
+    for (int k = 0; k < 256; k++) {
+        const int lo_n = lo[k], hi_n = hi[k];
+        lo[k] = lo_sum;
+        hi[k] = hi_sum;
+        lo_sum += lo_n;
+        hi_sum += hi_n;
+    }
+
+    // low byte, reading backward to get decreasing index on ties
+    for (int k = n - 1; k >= 0; k--) {
+        const Sortable s = sortables[k];
+        tmp[lo[255 - (s.key & 0xff)]++] = s;
+    }
+    // high byte (stable)
+    for (int k = 0; k < n; k++) {
+        const Sortable s = tmp[k];
+        sortables[hi[255 - (s.key >> 8)]++] = s;
+    }
 }
 
+// sort buffers bytes set aside per drawable (see draw_drawables)
+#define DRAWABLE_SORT_BYTES (2 * (int)sizeof(Sortable) + 2 * (int)sizeof(uint16_t))
+// alignment padding of the 4 sort buffers
+#define DRAWABLE_SORT_SLACK (4 * ARENA_ALIGN)
+
+// layering reference row (-1: no layers)
+static int _layer_row = -1;
+
 void reset_drawables() {
+    arena_reset();
+    arena_reserve(DRAWABLE_SORT_SLACK);
     _drawables.n = 0;
+    _drawables.sorted = 0;
+    _drawables.ordered = 0;
+    _drawables.last = NULL;
+    _layer_row = -1;
+}
+
+void set_drawables_layers(const int row) {
+    _layer_row = row;
 }
 
-Drawable* pop_drawable(const float sortkey) {
-    const int i = _drawables.n++;
-    if (_drawables.n >= MAX_DRAWABLES) {
-        pd->system->error("Drawable pool exhausted: %i/%i", _drawables.n, MAX_DRAWABLES);
+int get_drawable_layer(const float z) {
+    if (_layer_row < 0) return 0;
+
+    int j = (int)floorf(z / GROUND_CELL_SIZE);
+    if (j < -1) j = -1;
+    if (j > GROUND_HEIGHT) j = GROUND_HEIGHT;
+    // rows in front of the camera from far to near
+    if (j > _layer_row) return GROUND_HEIGHT - j;
+    // rows behind the camera from far to near
+    if (j < _layer_row) return GROUND_HEIGHT - _layer_row + j + 1;
+    // camera row
+    return GROUND_HEIGHT + 1;
+}
+
+static Drawable* pop_any_drawable(const int layer, const int ordered) {
+    // note: sort buffers are reserved upfront so that draw_drawables cannot run out of memory
+    if (!arena_reserve(DRAWABLE_SORT_BYTES)) return NULL;
+    Drawable* drawable = arena_alloc(sizeof(Drawable));
+    if (!drawable) {
+        arena_release(DRAWABLE_SORT_BYTES);
         return NULL;
     }
-    // pack everything into a int32    
-    _sortables[i] = (Sortable){ .i = i, .key = (uint16_t)(max(0.f,sortkey) * 256.0f) };
-    return &_drawables.all[i];
+    drawable->layer = (uint8_t)layer;
+    drawable->ordered = (uint8_t)ordered;
+    const uint16_t handle = ARENA_HANDLE(drawable);
+    if (_drawables.last) _drawables.last->next = handle;
+    else _drawables.first = handle;
+    _drawables.last = drawable;
+    _drawables.n++;
+    PROFILE_COUNT(PROFILE_COUNTER_DRAWABLES, 1);
+    return drawable;
+}
+
+Drawable* pop_drawable(const float sortkey, const int layer) {
+    Drawable* drawable = pop_any_drawable(layer, 0);
+    if (!drawable) return NULL;
+    // note: sort key is packed at draw time
+    drawable->key = sortkey;
+    _drawables.sorted++;
+    return drawable;
+}
+
+Drawable* pop_ordered_drawable(const int layer) {
+    Drawable* drawable = pop_any_drawable(layer, 1);
+    if (!drawable) return NULL;
+    _drawables.ordered++;
+    return drawable;
+}
+
+DrawableVertex* pop_drawable_vertices(const int n) {
+    return arena_alloc(n * sizeof(DrawableVertex));
 }
 
-void draw_drawables(uint8_t* bitmap) {
+static uint16_t get_drawable_key(const Drawable* drawable) {
+    return (uint16_t)(max(0.f, drawable->key) * 256.0f);
+}
+
+void draw_drawables(uint8_t* bitmap, const int front_to_back) {
+    capture_frame_begin(bitmap);
     if (_drawables.n > 0) {
-        qsort(_sortables, (size_t)_drawables.n, sizeof(Sortable), cmp_sortable);
+        PROFILE_ZONE_BEGIN(PROFILE_STAGE_SORT);
+        // sort buffers (arena handles)
+        // note: allocations cannot fail (space reserved by pop_any_drawable)
+        arena_release(_drawables.n * DRAWABLE_SORT_BYTES + DRAWABLE_SORT_SLACK);
+        const int n = _drawables.sorted;
+        Sortable* sortables = arena_alloc(n * sizeof(Sortable));
+        // radix sort scratch buffer
+        Sortable* tmp = arena_alloc(n * sizeof(Sortable));
+        uint16_t* ordered = arena_alloc(_drawables.ordered * sizeof(uint16_t));
+        // drawing order (back to front)
+        uint16_t* order = arena_alloc(_drawables.n * sizeof(uint16_t));
+        // drawables per layer (ordered, sorted)
+        int ordered_n[DRAWABLE_LAYERS] = {0};
+        int sorted_n[DRAWABLE_LAYERS] = {0};
+        int ns = 0, no = 0;
+        uint16_t handle = _drawables.first;
+        for (int k = 0; k < _drawables.n; k++) {
+            const Drawable* drawable = ARENA_PTR(handle);
+            if (drawable->ordered) {
+                ordered[no++] = handle;
+                ordered_n[drawable->layer]++;
+            }
+            else {
+                sortables[ns++] = (Sortable){ .i = handle, .key = get_drawable_key(drawable) };
+                sorted_n[drawable->layer]++;
+            }
+            handle = drawable->next;
+        }
+
+        radix_sort(sortables, tmp, n);
+        int count = n;
+        if (_layer_row < 0) {
+            for (int k = 0; k < n; k++) {
+                order[k] = sortables[k].i;
+            }
+        }
+        else {
+            // stable scatter by layer: ordered drawables (push order) first, then sorted drawables
+            int sum = 0;
+            for (int layer = 0; layer < DRAWABLE_LAYERS; layer++) {
+                const int layer_ordered = ordered_n[layer];
+                ordered_n[layer] = sum;
+                sum += layer_ordered;
+                const int layer_sorted = sorted_n[layer];
+                sorted_n[layer] = sum;
+                sum += layer_sorted;
+            }
+            for (int k = 0; k < no; k++) {
+                order[ordered_n[((Drawable*)ARENA_PTR(ordered[k]))->layer]++] = ordered[k];
+            }
+            for (int k = 0; k < n; k++) {
+                order[sorted_n[((Drawable*)ARENA_PTR(sortables[k].i))->layer]++] = sortables[k].i;
+            }
+            count = sum;
+        }
+        PROFILE_ZONE_END(PROFILE_STAGE_SORT);
 
         // rendering
-        const int n = _drawables.n;
-        for (int k = 0; k < n; k++) {
-            Drawable* drawable = &_drawables.all[_sortables[k].i];
-            drawable->draw(drawable, bitmap);
-        }        
+        PROFILE_ZONE_BEGIN(PROFILE_STAGE_RASTER);
+        if (front_to_back) {
+            sbuffer_begin();
+            for (int k = count - 1; k >= 0; k--) {
+                Drawable* drawable = ARENA_PTR(order[k]);
+                sbuffer_set_key(get_drawable_key(drawable));
+                drawable->draw(drawable, bitmap, DRAW_PASS_OPAQUE);
+            }
+            for (int k = 0; k < count; k++) {
+                Drawable* drawable = ARENA_PTR(order[k]);
+                sbuffer_set_key(get_drawable_key(drawable));
+                drawable->draw(drawable, bitmap, DRAW_PASS_DEFERRED);
+            }
+            sbuffer_end();
+        }
+        else {
+            for (int k = 0; k < count; k++) {
+                Drawable* drawable = ARENA_PTR(order[k]);
+                drawable->draw(drawable, bitmap, DRAW_PASS_ALL);
+            }
+        }
+        PROFILE_ZONE_END(PROFILE_STAGE_RASTER);
     }
+    capture_frame_end(bitmap);
+    arena_end_frame();
 }
 
 void drawables_init(PlaydateAPI* playdate) {
@@ -3,18 +3,35 @@
 
 #include <pd_api.h>
 #include "3dmath.h"
+#include "ground_limits.h"
+#include "arena.h"
 
+// reference drawable count (benchmarks)
+// note: drawables, vertices & sort buffers are allocated from the frame arena (see arena.h)
 #define MAX_DRAWABLES 2048
+// ground rows + out of ground rows + camera row
+#define DRAWABLE_LAYERS (GROUND_HEIGHT + 2)
+
+// face vertex (frame arena)
+typedef struct {
+    // ground tiles: screen space point (u: height shading, light: track contrast)
+    // 3d models: camera space point (u: sharp edge), projected in place by the opaque pass
+    Point3du p;
+    // ground tiles: 1/z
+    float w;
+} DrawableVertex;
 
 typedef struct {
     // texture type
-    int material;
+    uint8_t material;
     // original flags
-    int flags;
+    uint8_t flags;
     // number of points
-    int n;
-    // clipped points in camera space
-    Point3du pts[5];
+    uint8_t n;
+    // vertex arena handles (shared by unclipped ground tiles, owned otherwise)
+    uint16_t v[5];
+    // ground tiles: light attenuation
+    float light;
 } DrawableFace;
 
 typedef struct {    
@@ -30,13 +47,26 @@ typedef struct {
     Point3d pos;
 } DrawableParticle;
 
+// rendering passes
+// all: single back to front pass
+#define DRAW_PASS_ALL 0
+// front to back: opaque fills only
+#define DRAW_PASS_OPAQUE 1
+// back to front: transparent stuff (edges, particles) after opaque pass
+#define DRAW_PASS_DEFERRED 2
+
 struct Drawable_s;
-typedef void(*draw_drawable)(struct Drawable_s* drawable, uint8_t* bitmap);
+typedef void(*draw_drawable)(struct Drawable_s* drawable, uint8_t* bitmap, const int pass);
 
 // generic drawable thingy
 // cache-friendlyness???
 typedef struct Drawable_s {
     float key;
+    // next drawable in push order (arena handle)
+    uint16_t next;
+    uint8_t layer;
+    // drawn in push order within layer (see pop_ordered_drawable)
+    uint8_t ordered;
     draw_drawable draw;
     union {
         DrawableFace face;
@@ -44,9 +74,46 @@ typedef struct Drawable_s {
     };
 } Drawable;
 
+// packed sort key
+typedef struct {
+    union {
+        struct {
+            // low bits: drawable arena handle
+            uint16_t i;
+            // high bits (???)
+            uint16_t key;
+        };
+        uint32_t v;
+    };
+} Sortable;
+
+// sort by decreasing key, ties by decreasing index (e.g. same order as qsort on v)
+// assumes sortables are in increasing index order
+// tmp must hold n entries
+void radix_sort(Sortable* sortables, Sortable* tmp, const int n);
+
 void drawables_init(PlaydateAPI* playdate);
+// reset pool & frame arena (also disables layers)
 void reset_drawables();
-Drawable* pop_drawable(const float sortkey);
-void draw_drawables(uint8_t* bitmap);
+
+// drawables can be grouped by ground rows (layers), drawn in painter's order
+// relative to the given camera row
+// within a layer, ordered drawables are drawn first (in push order), followed by depth sorted drawables
+void set_drawables_layers(const int row);
+// layer of a world z position (0 when layers are not active)
+int get_drawable_layer(const float z);
+
+// note: pop functions return NULL when the frame arena is exhausted
+
+// depth sorted drawable
+Drawable* pop_drawable(const float sortkey, const int layer);
+// drawable rendered in push order (layers must be pushed in increasing order)
+Drawable* pop_ordered_drawable(const int layer);
+// n consecutive vertices (valid until next reset_drawables)
+DrawableVertex* pop_drawable_vertices(const int n);
+// vertex from arena handle
+#define DRAWABLE_VERTEX(handle) ((DrawableVertex*)ARENA_PTR(handle))
+// front_to_back: opaque pass front to back (S-buffer), then deferred pass back to front
+void draw_drawables(uint8_t* bitmap, const int front_to_back);
 
 #endif
@@ -1,7 +1,10 @@
 #include <pd_api.h>
 #include <float.h>
+#include <limits.h>
 #include "simd.h"
 #include "gfx.h"
+#include "profile.h"
+#include "capture.h"
 
 // float32 display ptr width
 #define LCD_ROWSIZE32 (LCD_ROWSIZE/4)
@@ -12,15 +15,207 @@ void gfx_init(PlaydateAPI* playdate) {
     pd = playdate;
 }
 
+// span buffer (S-buffer)
+// per scanline list of covered [x0,x1[ spans, sorted by x0 (touching spans are merged)
+// + per scanline log of drawn pieces with the depth key of their drawable (for nearer span tests)
+#define SBUFFER_MAX_SPANS 32
+#define SBUFFER_MAX_PIECES 64
+// max. number of uncovered pieces of a span
+#define SBUFFER_MAX_GAPS (SBUFFER_MAX_PIECES + 1)
+
+typedef struct {
+    int16_t x0;
+    int16_t x1;
+} Span;
+
+typedef struct {
+    int16_t x0;
+    int16_t x1;
+    uint16_t key;
+} KeySpan;
+
+static struct {
+    int active;
+    // depth key of active drawable
+    uint16_t key;
+    uint8_t n[LCD_ROWS];
+    Span spans[LCD_ROWS][SBUFFER_MAX_SPANS];
+    // drawn pieces (in drawing order)
+    uint8_t npieces[LCD_ROWS];
+    KeySpan pieces[LCD_ROWS][SBUFFER_MAX_PIECES];
+} _sbuffer;
+
+void sbuffer_begin() {
+    if (_capture_active) capture_sbuffer(CAPTURE_SBUFFER_BEGIN, 0);
+    _sbuffer.active = 1;
+    memset(_sbuffer.n, 0, sizeof(_sbuffer.n));
+    memset(_sbuffer.npieces, 0, sizeof(_sbuffer.npieces));
+}
+
+void sbuffer_end() {
+    if (_capture_active) capture_sbuffer(CAPTURE_SBUFFER_END, 0);
+    _sbuffer.active = 0;
+}
+
+void sbuffer_set_key(const uint16_t key) {
+    if (_capture_active) capture_sbuffer(CAPTURE_SBUFFER_KEY, key);
+    _sbuffer.key = key;
+}
+
+// returns uncovered pieces of [x1,x2[ and marks them as covered
+static int sbuffer_cover(const int y, const int x1, const int x2, int16_t* gaps) {
+    Span* spans = _sbuffer.spans[y];
+    const int n = _sbuffer.n[y];
+
+    // uncovered pieces
+    int ngaps = 0;
+    int x = x1;
+    int first = n, last = -1;
+    for (int k = 0; k < n && x < x2; k++) {
+        const Span* s = &spans[k];
+        // touching spans will be merged
+        if (s->x1 < x1) continue;
+        if (s->x0 > x2) break;
+        if (k < first) first = k;
+        last = k;
+        if (s->x1 <= x) continue;
+        if (s->x0 > x) {
+            gaps[ngaps++] = x;
+            gaps[ngaps++] = s->x0;
+        }
+        x = s->x1;
+    }
+    if (x < x2) {
+        gaps[ngaps++] = x;
+        gaps[ngaps++] = x2;
+    }
+    // fully covered
+    if (ngaps == 0) return 0;
+
+    // log drawn pieces
+    KeySpan* pieces = &_sbuffer.pieces[y][_sbuffer.npieces[y]];
+    const int npieces = min(ngaps / 2, SBUFFER_MAX_PIECES - _sbuffer.npieces[y]);
+    for (int k = 0; k < npieces; k++) {
+        pieces[k] = (KeySpan){ .x0 = gaps[2 * k], .x1 = gaps[2 * k + 1], .key = _sbuffer.key };
+    }
+    _sbuffer.npieces[y] += (uint8_t)npieces;
+    // note: pieces not logged never hide later drawables
+    if (npieces < ngaps / 2) PROFILE_COUNT(PROFILE_COUNTER_SBUFFER_OVERFLOWS, 1);
+
+    // find remaining touching spans
+    if (first == n) {
+        for (first = 0; first < n && spans[first].x1 < x1; first++);
+        last = first - 1;
+    }
+    for (; last + 1 < n && spans[last + 1].x0 <= x2; last++);
+
+    // merge [first, last] into new span
+    const int removed = last - first + 1;
+    const int count = n - removed + 1;
+    // overflow: keep line as is, pieces are drawn but stay uncovered
+    // note: never marks pixels as covered without drawing them
+    if (count > SBUFFER_MAX_SPANS) {
+        PROFILE_COUNT(PROFILE_COUNTER_SBUFFER_OVERFLOWS, 1);
+        return ngaps;
+    }
+    Span merged = { .x0 = (int16_t)x1, .x1 = (int16_t)x2 };
+    if (first <= last) {
+        if (spans[first].x0 < merged.x0) merged.x0 = spans[first].x0;
+        if (spans[last].x1 > merged.x1) merged.x1 = spans[last].x1;
+    }
+    memmove(&spans[first + 1], &spans[last + 1], (n - last - 1) * sizeof(Span));
+    spans[first] = merged;
+    _sbuffer.n[y] = (uint8_t)count;
+
+    return ngaps;
+}
+
+// returns pieces of [x1,x2[ not covered by a nearer drawn piece
+static int sbuffer_visible(const int y, const int x1, const int x2, int16_t* gaps) {
+    const KeySpan* pieces = _sbuffer.pieces[y];
+    const int n = _sbuffer.npieces[y];
+    const uint16_t key = _sbuffer.key;
+
+    // nearer pieces overlapping [x1,x2[, sorted by x0
+    // note: pieces are logged in drawing order (not sorted)
+    Span hidden[SBUFFER_MAX_PIECES];
+    int nhidden = 0;
+    for (int k = 0; k < n; k++) {
+        const KeySpan* s = &pieces[k];
+        if (s->key >= key || s->x1 <= x1 || s->x0 >= x2) continue;
+        int i = nhidden++;
+        for (; i > 0 && hidden[i - 1].x0 > s->x0; i--) hidden[i] = hidden[i - 1];
+        hidden[i] = (Span){ .x0 = s->x0, .x1 = s->x1 };
+    }
+
+    int ngaps = 0;
+    int x = x1;
+    for (int k = 0; k < nhidden && x < x2; k++) {
+        const Span* s = &hidden[k];
+        if (s->x1 <= x) continue;
+        if (s->x0 > x) {
+            gaps[ngaps++] = x;
+            gaps[ngaps++] = s->x0;
+        }
+        x = s->x1;
+    }
+    if (x < x2) {
+        gaps[ngaps++] = x;
+        gaps[ngaps++] = x2;
+    }
+    return ngaps;
+}
+
+static int sbuffer_is_visible(const int x, const int y) {
+    const KeySpan* pieces = _sbuffer.pieces[y];
+    const int n = _sbuffer.npieces[y];
+    for (int k = 0; k < n; k++) {
+        if (pieces[k].x0 <= x && x < pieces[k].x1 && pieces[k].key < _sbuffer.key) return 0;
+    }
+    return 1;
+}
 
+// span kernel
+// writes pixels [x1,x2[ of a row, one 32 pixels word at a time
+// always inlined: constant source & alpha arguments generate each fill variant
+// source: dither row (SPAN_SOURCE_COLOR) or dither ramp (SPAN_SOURCE_RAMP, shade interpolated per byte)
+// alpha: only pixels set in alpha mask are written
+#define SPAN_SOURCE_COLOR 0
+#define SPAN_SOURCE_RAMP 1
+
+typedef struct {
+    // dither row
+    uint32_t color;
+    // alpha mask row
+    uint32_t alpha;
+    // dither ramp row: 8 bytes per shade, columns (0 1 2 3) repeated twice
+    const uint8_t* ramp;
+    // 16.16 shade of first byte & increment per byte (8 pixels)
+    int u, du;
+    // first & last byte of span
+    int first, last;
+    // last byte shade clamped to 0 (can overflow into negative territory)
+    int clamp_last;
+} SpanSource;
+
+// ramp bytes of word col (bytes outside span are left to 0)
+// note: little endian (first byte in low bits)
 #if TARGET_PLAYDATE
 static __attribute__((always_inline))
 #else
 static __forceinline
 #endif
-void _drawMaskPattern(uint32_t* p, uint32_t mask, uint32_t color)
+uint32_t span_ramp_word(const SpanSource* src, const int col)
 {
-    *p = (*p & ~mask) | (color & mask);
+    const int b0 = col * 4;
+    const int c0 = max(b0, src->first), c1 = min(b0 + 3, src->last);
+    int u = src->u + (c0 - src->first) * src->du;
+    uint32_t word = 0;
+    for (int c = c0; c <= c1; c++, u += src->du) {
+        const int uc = (c == src->last && src->clamp_last && u < 0) ? 0 : u;
+        word |= (uint32_t)src->ramp[(uc >> 16) * 8 + (c & 3)] << (8 * (c - b0));
+    }
+    return word;
 }
 
 #if TARGET_PLAYDATE
@@ -28,71 +223,174 @@ static __attribute__((always_inline))
 #else
 static __forceinline
 #endif
-void _drawMaskPatternOpaque(uint32_t* p, uint32_t color)
+uint32_t span_word(const SpanSource* src, const int source, const int col)
 {
-    *p = color;
+    return source == SPAN_SOURCE_RAMP ? span_ramp_word(src, col) : src->color;
 }
 
-static void drawFragment(uint32_t* row, int x1, int x2, uint32_t color)
+#if TARGET_PLAYDATE
+static __attribute__((always_inline))
+#else
+static __forceinline
+#endif
+void span_write(uint32_t* p, const uint32_t mask, const uint32_t word, const SpanSource* src, const int alpha)
 {
-    if (x2 < 0 || x1 >= LCD_COLUMNS)
-        return;
+    const uint32_t m = alpha ? mask & src->alpha : mask;
+    *p = (*p & ~m) | (word & m);
+}
+
+// whole words store size (bytes): 4 on device, 8 on 64-bit hosts
+// note: ramps are 8 bytes per shade, columns repeated twice
+#if TARGET_PLAYDATE
+#define TEXTURE_WORD 4
+typedef uint32_t texture_word_t;
+#else
+#define TEXTURE_WORD 8
+typedef uint64_t texture_word_t;
+#endif
+
+// 32-bit row word repeated over a store word
+#if TARGET_PLAYDATE
+static __attribute__((always_inline))
+#else
+static __forceinline
+#endif
+texture_word_t span_repeat(const uint32_t word)
+{
+#if TEXTURE_WORD == 8
+    return (texture_word_t)word | ((texture_word_t)word << 32);
+#else
+    return word;
+#endif
+}
 
+// n ramp bytes starting at shade u (n: 4 or TEXTURE_WORD, no clamping)
+#if TARGET_PLAYDATE
+static __attribute__((always_inline))
+#else
+static __forceinline
+#endif
+texture_word_t span_ramp_bytes(const SpanSource* src, const int u, const int n)
+{
+    const int du = src->du;
+    const int shade = u >> 16;
+    texture_word_t word = 0;
+    if (shade == ((u + (n - 1) * du) >> 16)) {
+        // same shade: copy of ramp columns (0 1 2 3 0 1 2 3)
+        memcpy(&word, src->ramp + shade * 8, n);
+    }
+    else {
+        // note: little endian (first byte in low bits)
+        int ub = u;
+        for (int b = 0; b < n; b++, ub += du) {
+            word |= (texture_word_t)src->ramp[(ub >> 16) * 8 + (b & 3)] << (8 * b);
+        }
+    }
+    return word;
+}
+
+// writes n bytes of whole row words
+#if TARGET_PLAYDATE
+static __attribute__((always_inline))
+#else
+static __forceinline
+#endif
+void span_store(uint32_t* p, const texture_word_t word, const SpanSource* src, const int alpha, const int n)
+{
+    if (alpha) {
+        texture_word_t dst = 0;
+        memcpy(&dst, p, n);
+        const texture_word_t m = span_repeat(src->alpha);
+        dst = (dst & ~m) | (word & m);
+        memcpy(p, &dst, n);
+    }
+    else {
+        memcpy(p, &word, n);
+    }
+}
+
+#if TARGET_PLAYDATE
+static __attribute__((always_inline))
+#else
+static __forceinline
+#endif
+void span_kernel(uint32_t* row, int x1, int x2, const SpanSource* src, const int source, const int alpha)
+{
     if (x1 < 0)
         x1 = 0;
 
     if (x2 > LCD_COLUMNS)
         x2 = LCD_COLUMNS;
 
-    if (x1 > x2)
+    if (x1 >= x2)
         return;
 
-    // Operate on 32 bits at a time
-
-    const int startbit = x1 & 31;
-    const uint32_t startmask = swap((1 << (32 - startbit)) - 1);
+    // bitmap bit order: leftmost pixel in high bit of first byte
+    const int col = x1 >> 5, last = (x2 - 1) >> 5;
     const int endbit = x2 & 31;
-    const uint32_t endmask = swap(((1 << endbit) - 1) << (32 - endbit));
-
-    const int col = x1 >> 5;
+    const uint32_t startmask = swap(0xffffffff >> (x1 & 31));
+    const uint32_t endmask = endbit ? swap(~(0xffffffff >> endbit)) : 0xffffffff;
     uint32_t* p = row + col;
 
-    if (col == x2 >> 5)
+    if (col == last)
     {
-        uint32_t mask = 0;
-
-        if (startbit > 0 && endbit > 0)
-            mask = startmask & endmask;
-        else if (startbit > 0)
-            mask = startmask;
-        else if (endbit > 0)
-            mask = endmask;
+        span_write(p, startmask & endmask, span_word(src, source, col), src, alpha);
+        return;
+    }
 
-        _drawMaskPattern(p, mask, color);
+    span_write(p++, startmask, span_word(src, source, col), src, alpha);
+    int k = col + 1;
+    // whole words, TEXTURE_WORD bytes per store
+    const int step = TEXTURE_WORD / 4;
+    if (source == SPAN_SOURCE_RAMP)
+    {
+        const int du = src->du;
+        int u = src->u + (4 * k - src->first) * du;
+        for (; k + step <= last; k += step, p += step, u += TEXTURE_WORD * du)
+        {
+            span_store(p, span_ramp_bytes(src, u, TEXTURE_WORD), src, alpha, TEXTURE_WORD);
+        }
+        // remaining row words
+        for (; k < last; k++, p++, u += 4 * du)
+        {
+            span_store(p, span_ramp_bytes(src, u, 4), src, alpha, 4);
+        }
     }
     else
     {
-        int x = x1;
-
-        if (startbit > 0)
+        const texture_word_t word = span_repeat(src->color);
+        for (; k + step <= last; k += step, p += step)
         {
-            _drawMaskPattern(p++, startmask, color);
-            x += (32 - startbit);
+            span_store(p, word, src, alpha, TEXTURE_WORD);
         }
-
-        x2 -= 32;
-        while (x <= x2)
+        for (; k < last; k++, p++)
         {
-            _drawMaskPatternOpaque(p++, color);
-            x += 32;
+            span_store(p, word, src, alpha, 4);
         }
-
-        if (endbit > 0)
-            _drawMaskPattern(p, endmask, color);
     }
+
+    span_write(p, endmask, span_word(src, source, last), src, alpha);
+}
+
+static void drawFragment(uint32_t* row, int x1, int x2, uint32_t color)
+{
+    const SpanSource src = { .color = color };
+    span_kernel(row, x1, x2, &src, SPAN_SOURCE_COLOR, 0);
 }
 
-static void drawTextureFragment(uint8_t* row, int x1, int x2, int lu, int ru, uint8_t* dither_ramp)
+static void drawAlphaFragment(uint32_t* row, int x1, int x2, uint32_t color, uint32_t alpha)
+{
+    const SpanSource src = { .color = color, .alpha = alpha };
+    span_kernel(row, x1, x2, &src, SPAN_SOURCE_COLOR, 1);
+}
+
+// lu/ru: 16.16 shades at x1/x2
+#if TARGET_PLAYDATE
+static __attribute__((always_inline))
+#else
+static __forceinline
+#endif
+void drawTextureFragment(uint32_t* row, int x1, int x2, int lu, int ru, const uint8_t* dither_ramp, const uint32_t alpha, const int transparent)
 {
     if (x2 < 0 || x1 >= LCD_COLUMNS)
         return;
@@ -105,291 +403,295 @@ static void drawTextureFragment(uint8_t* row, int x1, int x2, int lu, int ru, ui
         lu -= x1 * du;
         x1 = 0;
     }
-    
+
     if (x2 > LCD_COLUMNS)
         x2 = LCD_COLUMNS;
 
-    if (x1 > x2)
+    if (x1 >= x2)
         return;
 
-    // Operate on 8 bits at a time
-
-    const int startbit = x1 & 7;
-    const uint8_t startmask = (1 << (8 - startbit)) - 1;
-    const int endbit = x2 & 7;
-    const uint8_t endmask = ((1 << endbit) - 1) << (8 - endbit);
-
-    // ensure lu by step of 8*du do not overlap with invalid noise
-    // dither_ramp++;
-
-    // move by whole shading block (2x32 pixels)
-    du *= 8;
-    
-    const int col = x1 >> 3;
-    uint8_t* p = row + col;
-    
-    if (col == x2 >> 3)
-    {
-        uint8_t mask = 0;
+    // move by whole shading block (8 pixels)
+    const SpanSource src = {
+        .alpha = alpha,
+        .ramp = dither_ramp,
+        .u = lu,
+        .du = du * 8,
+        .first = x1 >> 3,
+        .last = (x2 - 1) >> 3,
+        .clamp_last = (x2 & 7) && (x1 >> 3) != ((x2 - 1) >> 3) };
+    span_kernel(row, x1, x2, &src, SPAN_SOURCE_RAMP, transparent);
+}
 
-        if (startbit > 0 && endbit > 0)
-            mask = startmask & endmask;
-        else if (startbit > 0)
-            mask = startmask;
-        else if (endbit > 0)
-            mask = endmask;
+// polygon edges
+// converted once per polygon to 16.16 fixed point: one reciprocal per edge, x (and attributes)
+// per vertex, shared by the left (increasing index) and right (decreasing index) edge walks
+#define EDGE_MAX_VERTS 8
+// interpolated attributes (in order): u, light
+#define EDGE_MAX_ATTRS 2
+
+typedef struct {
+    int n;
+    // top vertex & vertical extent (scanlines [ystart, yend[)
+    int top;
+    int ystart;
+    int yend;
+    // per vertex
+    float y[EDGE_MAX_VERTS];
+    int x[EDGE_MAX_VERTS];
+    int a[EDGE_MAX_VERTS][EDGE_MAX_ATTRS];
+    // per edge (vertex i to i + 1)
+    int dx[EDGE_MAX_VERTS];
+    int da[EDGE_MAX_VERTS][EDGE_MAX_ATTRS];
+} EdgeSetup;
+
+typedef struct {
+    // current vertex
+    int i;
+    // last scanline of current edge
+    int ly;
+    int x, dx;
+    int a[EDGE_MAX_ATTRS], da[EDGE_MAX_ATTRS];
+} EdgeWalk;
+
+// returns 0 if polygon is out of screen
+#if TARGET_PLAYDATE
+static __attribute__((always_inline))
+#else
+static __forceinline
+#endif
+int edge_setup(EdgeSetup* edges, const Point3du* verts, const int n, const int attrs) {
+    // note: clipped polygons have at most 5 vertices
+    if (n > EDGE_MAX_VERTS) {
+        pd->system->error("Polygon has too many vertices: %i (max: %i)", n, EDGE_MAX_VERTS);
+        return 0;
+    }
+    float miny = FLT_MAX, maxy = -FLT_MAX;
+    int mini = -1;
+    // find extent
+    for (int i = 0; i < n; ++i) {
+        const float y = verts[i].y;
+        if (y < miny) miny = y, mini = i;
+        if (y > maxy) maxy = y;
+    }
+    // out of screen?
+    if (miny > LCD_ROWS || maxy < 0.f) {
+        return 0;
+    }
+    edges->n = n;
+    edges->top = mini;
+    edges->ystart = (int)ceilf(miny);
+    edges->yend = (int)ceilf(maxy);
+    if (edges->yend > LCD_ROWS) edges->yend = LCD_ROWS;
+    if (edges->ystart < 0) edges->ystart = 0;
 
-        *p = (*p & ~mask) | ((*(dither_ramp + (lu >> 16) * 8 + (col&3))) & mask);
+    for (int i = 0; i < n; ++i) {
+        const Point3du* p0 = &verts[i];
+        edges->y[i] = p0->y;
+        edges->x[i] = __TOFIXED16(p0->x);
+        if (attrs > 0) edges->a[i][0] = __TOFIXED16(p0->u);
+        if (attrs > 1) edges->a[i][1] = __TOFIXED16(p0->light);
     }
-    else
-    {
-        int x = x1;
+    for (int i = 0; i < n; ++i) {
+        const Point3du* p0 = &verts[i];
+        const Point3du* p1 = &verts[i + 1 < n ? i + 1 : 0];
+        // note: same slope walking down from either end
+        const float w = 1.f / (p1->y - p0->y);
+        edges->dx[i] = __TOFIXED16((p1->x - p0->x) * w);
+        if (attrs > 0) edges->da[i][0] = __TOFIXED16((p1->u - p0->u) * w);
+        if (attrs > 1) edges->da[i][1] = __TOFIXED16((p1->light - p0->light) * w);
+    }
+    return 1;
+}
 
-        if (startbit > 0)
-        {
-            *p = (*p & ~startmask) | ((*(dither_ramp + (lu >> 16) * 8 + ((x>>3) & 3))) & startmask);
-            x += (8 - startbit);
-            lu += du;
-            p++;
-        }
+#if TARGET_PLAYDATE
+static __attribute__((always_inline))
+#else
+static __forceinline
+#endif
+void edge_start(const EdgeSetup* edges, EdgeWalk* walk) {
+    // note: x & attributes are set by the first edge_update
+    *walk = (EdgeWalk){ .i = edges->top, .ly = -1 };
+}
 
-        x2 -= 8;
-        while (x <= x2)
-        {
-            *(p++) = *(dither_ramp + (lu >> 16) * 8 + ((x >>3) & 3));
-            lu += du;
-            x += 8;
+// move to edge covering scanline y (dir: 1 left edge, -1 right edge)
+#if TARGET_PLAYDATE
+static __attribute__((always_inline))
+#else
+static __forceinline
+#endif
+void edge_update(const EdgeSetup* edges, EdgeWalk* walk, const int y, const int dir, const int attrs) {
+    while (walk->ly < y) {
+        const int i0 = walk->i;
+        int i1 = i0 + dir;
+        if (i1 >= edges->n) i1 = 0;
+        if (i1 < 0) i1 = edges->n - 1;
+        const int e = dir > 0 ? i0 : i1;
+        walk->i = i1;
+        walk->ly = (int)edges->y[i1];
+        walk->dx = edges->dx[e];
+        //sub - pixel correction
+        const float cy = y - edges->y[i0];
+        walk->x = edges->x[i0] + (int)(cy * walk->dx);
+        for (int k = 0; k < attrs; k++) {
+            walk->da[k] = edges->da[e][k];
+            walk->a[k] = edges->a[i0][k] + (int)(cy * walk->da[k]);
         }
+    }
+}
 
-        if (endbit > 0) {
-            // the last block of 8 pixels can overflow into negative territory
-            if (lu < 0) lu = 0;           
-            *p = (*p & ~endmask) | ((*(dither_ramp + (lu >> 16) * 8 + ((x>>3) & 3))) & endmask);
-        }
+// next scanline
+#if TARGET_PLAYDATE
+static __attribute__((always_inline))
+#else
+static __forceinline
+#endif
+void edge_step(EdgeWalk* walk, const int attrs) {
+    walk->x += walk->dx;
+    for (int k = 0; k < attrs; k++) {
+        walk->a[k] += walk->da[k];
     }
 }
 
 void polyfill(const Point3du* verts, const int n, uint32_t* dither, uint32_t* bitmap) {
-	float miny = FLT_MAX, maxy = -FLT_MAX;
-	int mini = -1;
-	// find extent
-	for (int i = 0; i < n; ++i) {
-		float y = verts[i].y;
-		if (y < miny) miny = y, mini = i;
-		if (y > maxy) maxy = y;
-	}
-    // out of screen?
-    if (miny > LCD_ROWS || maxy < 0.f) {
-        return;
-    }
+    if (_capture_active) capture_fill(CAPTURE_POLYFILL, verts, n, dither, 0);
+    EdgeSetup edges;
+    if (!edge_setup(&edges, verts, n, 0)) return;
 
-	// data for left& right edges :
-	int lj = mini, rj = mini;
-    int ly = -1, ry = -1;
-    int lx = 0, ldx = 0, rx = 0, rdx = 0;
-    int ystart = (int)ceilf(miny), yend = (int)ceilf(maxy);
-    if (yend > LCD_ROWS) yend = LCD_ROWS;
-    if (ystart < 0) ystart = 0;
+    // data for left& right edges :
+    EdgeWalk left, right;
+    edge_start(&edges, &left);
+    edge_start(&edges, &right);
+    const int ystart = edges.ystart, yend = edges.yend;
+    PROFILE_COUNT(PROFILE_COUNTER_SCANLINES, yend - ystart);
     bitmap += ystart * LCD_ROWSIZE32;
-    for (int y = ystart; y < yend; y++, bitmap += LCD_ROWSIZE32, lx += ldx, rx += rdx) {
+    for (int y = ystart; y < yend; y++, bitmap += LCD_ROWSIZE32, edge_step(&left, 0), edge_step(&right, 0)) {
         // maybe update to next vert
-        while (ly < y) {
-            const Point3du* p0 = &verts[lj];
-            // lj = (lj + 1) % n;
-            lj++;
-            if (lj >= n) lj = 0;
-            const Point3du* p1 = &verts[lj];
-            const float y0 = p0->y, y1 = p1->y;
-            ly = (int)y1;
-            ldx = __TOFIXED16((p1->x - p0->x) / (y1 - y0));
-            //sub - pixel correction
-            lx = __TOFIXED16(p0->x) + (int)((y - y0) * ldx);
+        edge_update(&edges, &left, y, 1, 0);
+        edge_update(&edges, &right, y, -1, 0);
+        const int lx = left.x, rx = right.x;
+
+        if (_sbuffer.active) {
+            int16_t gaps[2 * SBUFFER_MAX_GAPS];
+            int x1 = lx >> 16, x2 = rx >> 16;
+            if (x1 < 0) x1 = 0;
+            if (x2 > LCD_COLUMNS) x2 = LCD_COLUMNS;
+            if (x1 >= x2) continue;
+            const int ngaps = sbuffer_cover(y, x1, x2, gaps);
+            for (int k = 0; k < ngaps; k += 2) {
+                drawFragment(bitmap, gaps[k], gaps[k + 1], dither[y & 31]);
+            }
         }
-        while (ry < y) {
-            const Point3du* p0 = &verts[rj];
-            // rj = (rj + n - 1) % n;
-            rj--;
-            if (rj < 0) rj = n - 1;
-            const Point3du* p1 = &verts[rj];
-            const float y0 = p0->y, y1 = p1->y;
-            ry = (int)y1;
-            rdx = __TOFIXED16((p1->x - p0->x) / (y1 - y0));
-            //sub - pixel correction
-            rx = __TOFIXED16(p0->x) + (int)((y - y0) * rdx);
+        else {
+            drawFragment(bitmap, lx >> 16, rx >> 16, dither[y & 31]);
         }
-
-        drawFragment(bitmap, lx>>16, rx>>16, dither[y&31]);
     } 
 }
 
 // affine texturing (using dither pattern)
-// z contains dither color
-void texfill(const Point3du* verts, const int n, uint8_t* dither_ramp, uint8_t* bitmap) {
-    float miny = FLT_MAX, maxy = -FLT_MAX;
-    int mini = -1;
-    // find extent
-    for (int i = 0; i < n; ++i) {
-        float y = verts[i].y;
-        if (y < miny) miny = y, mini = i;
-        if (y > maxy) maxy = y;
-    }
-    // out of screen?
-    if (miny > LCD_ROWS || maxy < 0) {
-        return;
-    }
+// u contains dither shade
+// transparent: only pixels set in alpha mask are written (no S-buffer coverage)
+#if TARGET_PLAYDATE
+static __attribute__((always_inline))
+#else
+static __forceinline
+#endif
+void texfill_kernel(const Point3du* verts, const int n, uint8_t* dither_ramp, uint32_t* alpha, uint8_t* bitmap, const int transparent) {
+    EdgeSetup edges;
+    if (!edge_setup(&edges, verts, n, 1)) return;
 
     // data for left& right edges :
-    int lj = mini, rj = mini;
-    int ly = -1, ry = -1;
-    int lx = 0, ldx = 0, rx = 0, rdx = 0;
-    int lu = 0, ldu = 0, ru = 0, rdu = 0;   
-    int ystart = (int)ceilf(miny), yend = (int)ceilf(maxy);
-    if (yend > LCD_ROWS) yend = LCD_ROWS;
-    if (ystart < 0) ystart = 0;
+    EdgeWalk left, right;
+    edge_start(&edges, &left);
+    edge_start(&edges, &right);
+    const int ystart = edges.ystart, yend = edges.yend;
+    PROFILE_COUNT(PROFILE_COUNTER_SCANLINES, yend - ystart);
     bitmap += ystart * LCD_ROWSIZE;
-    for (int y = ystart; y < yend; y++, bitmap += LCD_ROWSIZE, lx += ldx, rx += rdx, lu += ldu,ru += rdu) {
+    for (int y = ystart; y < yend; y++, bitmap += LCD_ROWSIZE, edge_step(&left, 1), edge_step(&right, 1)) {
         // maybe update to next vert
-        while (ly < y) {
-            const Point3du* p0 = &verts[lj];
-            lj++;
-            if (lj >= n) lj = 0;
-            const Point3du* p1 = &verts[lj];
-            const float y0 = p0->y, y1 = p1->y;
-            const float dy = y1 - y0;
-            ly = (int)y1;
-            ldx = __TOFIXED16((p1->x - p0->x) / dy);
-            ldu = __TOFIXED16((p1->u - p0->u) / dy);
-            //sub - pixel correction
-            const float cy = y - y0;
-            lx = __TOFIXED16(p0->x) + (int)(cy * ldx);
-            lu = __TOFIXED16(p0->u) + (int)(cy * ldu);
+        edge_update(&edges, &left, y, 1, 1);
+        edge_update(&edges, &right, y, -1, 1);
+        const int lx = left.x, rx = right.x;
+        const int lu = left.a[0], ru = right.a[0];
+        const uint8_t* ramp = dither_ramp + (y & 31) * 8 * 16;
+        const uint32_t mask = transparent ? alpha[y & 31] : 0;
+        if (_sbuffer.active) {
+            int16_t gaps[2 * SBUFFER_MAX_GAPS];
+            const int x1 = lx >> 16, x2 = rx >> 16;
+            const int dx = x2 - x1;
+            if (dx <= 0) continue;
+            const int du = (ru - lu) / dx;
+            const int ngaps = transparent ?
+                sbuffer_visible(y, max(0, x1), min(LCD_COLUMNS, x2), gaps) :
+                sbuffer_cover(y, max(0, x1), min(LCD_COLUMNS, x2), gaps);
+            for (int k = 0; k < ngaps; k += 2) {
+                const int a = gaps[k], b = gaps[k + 1];
+                drawTextureFragment((uint32_t*)bitmap, a, b, lu + (a - x1) * du, lu + (b - x1) * du, ramp, mask, transparent);
+            }
         }
-        while (ry < y) {
-            const Point3du* p0 = &verts[rj];
-            rj--;
-            if (rj < 0) rj = n - 1;
-            const Point3du* p1 = &verts[rj];
-            const float y0 = p0->y, y1 = p1->y;
-            const float dy = y1 - y0;
-            ry = (int)y1;
-            rdx = __TOFIXED16((p1->x - p0->x) / dy);
-            rdu = __TOFIXED16((p1->u - p0->u) / dy);
-            //sub - pixel correction
-            const float cy = y - y0;
-            rx = __TOFIXED16(p0->x) + (int)(cy * rdx);
-            ru = __TOFIXED16(p0->u) + (int)(cy * rdu);
+        else {
+            drawTextureFragment((uint32_t*)bitmap, lx >> 16, rx >> 16, lu, ru, ramp, mask, transparent);
         }
-        drawTextureFragment(bitmap, lx >> 16, rx >> 16, lu, ru, dither_ramp + (y & 31) * 8 * 16);
     }
 }
 
-// alpha polyfill
-static void drawAlphaFragment(uint32_t* row, int x1, int x2, uint32_t color, uint32_t alpha)
-{
-    if (x2 < 0 || x1 >= LCD_COLUMNS)
-        return;
-
-    if (x1 < 0)
-        x1 = 0;
-
-    if (x2 > LCD_COLUMNS)
-        x2 = LCD_COLUMNS;
-
-    if (x1 > x2)
-        return;
-
-    // Operate on 32 bits at a time
-
-    const int startbit = x1 & 31;
-    const uint32_t startmask = swap((1 << (32 - startbit)) - 1);
-    const int endbit = x2 & 31;
-    const uint32_t endmask = swap(((1 << endbit) - 1) << (32 - endbit));
-
-    int col = x1 / 32;
-    uint32_t* p = row + col;
-
-    if (col == x2 / 32)
-    {
-        uint32_t mask = 0;
-
-        if (startbit > 0 && endbit > 0)
-            mask = startmask & endmask;
-        else if (startbit > 0)
-            mask = startmask;
-        else if (endbit > 0)
-            mask = endmask;
-
-        _drawMaskPattern(p, alpha & mask, color);
-    }
-    else
-    {
-        int x = x1;
-
-        if (startbit > 0)
-        {
-            _drawMaskPattern(p++, alpha & startmask, color);
-            x += (32 - startbit);
-        }
-
-        x2 -= 32;
-        while (x <= x2)
-        {
-            _drawMaskPattern(p++, alpha, color);
-            x += 32;
-        }
+void texfill(const Point3du* verts, const int n, uint8_t* dither_ramp, uint8_t* bitmap) {
+    if (_capture_active) capture_fill(CAPTURE_TEXFILL, verts, n, dither_ramp, 0);
+    texfill_kernel(verts, n, dither_ramp, NULL, bitmap, 0);
+}
 
-        if (endbit > 0)
-            _drawMaskPattern(p, alpha & endmask, color);
-    }
+void texalphafill(const Point3du* verts, const int n, uint8_t* dither_ramp, uint32_t* alpha, uint8_t* bitmap) {
+    if (_capture_active) capture_fill(CAPTURE_TEXALPHAFILL, verts, n, dither_ramp, capture_table_ref(alpha));
+    texfill_kernel(verts, n, dither_ramp, alpha, bitmap, 1);
 }
 
 void alphafill(const Point3du* verts, const int n, uint32_t color, uint32_t* alpha, uint32_t* bitmap) {
-    float miny = FLT_MAX, maxy = -FLT_MAX;
-    int mini = -1;
-    // find extent
-    for (int i = 0; i < n; ++i) {
-        float y = verts[i].y;
-        if (y < miny) miny = y, mini = i;
-        if (y > maxy) maxy = y;
-    }
-    // out of screen?
-    if (miny > LCD_ROWS || maxy < 0) {
-        return;
-    }
+    if (_capture_active) capture_fill(CAPTURE_ALPHAFILL, verts, n, alpha, color);
+    EdgeSetup edges;
+    if (!edge_setup(&edges, verts, n, 0)) return;
 
     // data for left& right edges :
-    int lj = mini, rj = mini;
-    int ly = -1, ry = -1;
-    int lx = 0, ldx = 0, rx = 0, rdx = 0;
-    int ystart = (int)ceilf(miny), yend = (int)ceilf(maxy);
-    if (yend > LCD_ROWS) yend = LCD_ROWS;
-    if (ystart < 0) ystart = 0;
+    EdgeWalk left, right;
+    edge_start(&edges, &left);
+    edge_start(&edges, &right);
+    const int ystart = edges.ystart, yend = edges.yend;
+    PROFILE_COUNT(PROFILE_COUNTER_SCANLINES, yend - ystart);
     bitmap += ystart * LCD_ROWSIZE32;
-    for (int y = ystart; y < yend; y++, bitmap += LCD_ROWSIZE32, lx += ldx, rx += rdx) {
+    for (int y = ystart; y < yend; y++, bitmap += LCD_ROWSIZE32, edge_step(&left, 0), edge_step(&right, 0)) {
         // maybe update to next vert
-        while (ly < y) {
-            const Point3du* p0 = &verts[lj];
-            lj++;
-            if (lj >= n) lj = 0;
-            const Point3du* p1 = &verts[lj];
-            const float y0 = p0->y, y1 = p1->y;
-            ly = (int)y1;
-            ldx = __TOFIXED16((p1->x - p0->x) / (y1 - y0));
-            //sub - pixel correction
-            lx = __TOFIXED16(p0->x) + (int)((y - y0) * ldx);
+        edge_update(&edges, &left, y, 1, 0);
+        edge_update(&edges, &right, y, -1, 0);
+        const int lx = left.x, rx = right.x;
+
+        if (_sbuffer.active) {
+            int16_t gaps[2 * SBUFFER_MAX_GAPS];
+            int x1 = lx >> 16, x2 = rx >> 16;
+            if (x1 < 0) x1 = 0;
+            if (x2 > LCD_COLUMNS) x2 = LCD_COLUMNS;
+            if (x1 >= x2) continue;
+            const int ngaps = sbuffer_visible(y, x1, x2, gaps);
+            for (int k = 0; k < ngaps; k += 2) {
+                drawAlphaFragment(bitmap, gaps[k], gaps[k + 1], color, alpha[y & 31]);
+            }
         }
-        while (ry < y) {
-            const Point3du* p0 = &verts[rj];
-            rj--;
-            if (rj < 0) rj = n - 1;
-            const Point3du* p1 = &verts[rj];
-            const float y0 = p0->y, y1 = p1->y;
-            ry = (int)y1;
-            rdx = __TOFIXED16((p1->x - p0->x) / (y1 - y0));
-            //sub - pixel correction
-            rx = __TOFIXED16(p0->x) + (int)((y - y0) * rdx);
+        else {
+            drawAlphaFragment(bitmap, lx >> 16, rx >> 16, color, alpha[y & 31]);
         }
+    }
+}
 
-        drawAlphaFragment(bitmap, lx >> 16, rx >> 16, color, alpha[y & 31]);        
+// black line, hidden by nearer spans (S-buffer active only)
+void sbuffer_line(int x0, int y0, const int x1, const int y1, uint8_t* bitmap) {
+    if (_capture_active) capture_line(CAPTURE_SBUFFER_LINE, x0, y0, x1, y1);
+    const int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+    const int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+    for (;;) {
+        if (x0 >= 0 && x0 < LCD_COLUMNS && y0 >= 0 && y0 < LCD_ROWS && sbuffer_is_visible(x0, y0)) {
+            bitmap[y0 * LCD_ROWSIZE + (x0 >> 3)] &= ~(0x80 >> (x0 & 7));
+        }
+        if (x0 == x1 && y0 == y1) break;
+        const int e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x0 += sx; }
+        if (e2 <= dx) { err += dx; y0 += sy; }
     }
 }
@@ -7,5 +7,16 @@ void gfx_init(PlaydateAPI* playdate);
 void polyfill(const Point3du* verts, const int n, uint32_t* dither, uint32_t* bitmap);
 void texfill(const Point3du* verts, const int n, uint8_t* dither_ramp, uint8_t* bitmap);
 void alphafill(const Point3du* verts, const int n, uint32_t color, uint32_t* alpha, uint32_t* bitmap);
+// texfill, only writing pixels set in alpha mask (e.g. fading tiles)
+void texalphafill(const Point3du* verts, const int n, uint8_t* dither_ramp, uint32_t* alpha, uint8_t* bitmap);
+
+// front to back rendering (S-buffer)
+// when active, polyfill/texfill only write uncovered pixels (and mark them as covered)
+// alphafill, texalphafill & sbuffer_line only write pixels not covered by a nearer span
+void sbuffer_begin();
+void sbuffer_end();
+// depth key of next primitives
+void sbuffer_set_key(const uint16_t key);
+void sbuffer_line(int x0, int y0, const int x1, const int y1, uint8_t* bitmap);
 
 #endif
@@ -13,9 +13,14 @@
 #include "models.h"
 #include "particles.h"
 #include "drawables.h"
+#include "arena.h"
 #include "ground_limits.h"
 #include "simd.h"
 #include "rand_r.h"
+#include "profile.h"
+#include "visibility.h"
+#include "horizon.h"
+#include "capture.h"
 
 static PlaydateAPI* pd;
 
@@ -31,6 +36,14 @@ typedef struct {
     int flags;
 } GroundFace;
 
+// course generator state (before a slice is generated)
+typedef struct {
+    int slice_id;
+    float slice_y;
+    float noise_y_offset;
+    TracksState tracks;
+} GeneratorState;
+
 // ground tile
 typedef struct {
     int prop_id;
@@ -52,22 +65,27 @@ typedef struct {
     // tiles (horiz row)
     float heights[GROUND_WIDTH];
     GroundTile tiles[GROUND_WIDTH];
-} GroundSlice;
 
-// active slices + misc "globals"
-typedef struct {
-    // 
+    // generator state after this slice (reported when slice enters view)
     int slice_id;
-    // start slice index
-    int plyr_z_index;
-    int max_pz;
-    int r_seed;
-    float slice_y;
-    float noise_y_offset;
-    // active tracks
-    Tracks* tracks;
-    GroundSlice* slices[GROUND_HEIGHT];
-} Ground;
+    TrackPattern pattern;
+
+    // generation inputs (see save_ground_state)
+    GeneratorState gen;
+    // make_slice altitude
+    float gen_y;
+    // make_slice base altitude (relative to y, invariant to rebasing)
+    float gen_base_dy;
+} GroundSlice;
+
+// number of slices generated ahead of the visible window
+#define GROUND_PREFETCH 8
+#define GROUND_SLICES (GROUND_HEIGHT + GROUND_PREFETCH)
+
+// slices y precision
+#define SLICE_Y_SCALE 256.f
+// max. vertical offset before slices are rebased (keeps y offsetting exact)
+#define GROUND_MAX_Y_OFFSET 1024.f
 
 #define PROP_FLAG_HITABLE   1
 #define PROP_FLAG_COLLECT   2
@@ -83,16 +101,15 @@ typedef struct {
     int flags;
     float radius;
     ThreeDModel* model;
+    // model bounds (vertical cylinder)
+    float bounds_radius;
+    FloatRange bounds_y;
 } PropProperties;
 
 static PropProperties _props_properties[NEXT_PROP_ID + 1] = {0};
 
 // max. number of props on a given slice (e.g. number of tracks + 1)
 #define MAX_PROPS 4
-static struct {
-    int n;
-    PropInfo props[MAX_PROPS];
-} _props_info;
 
 // 3d objects owned by lua but rendered by C
 #define MAX_RENDER_PROPS 16
@@ -108,20 +125,72 @@ static struct {
     RenderProp props[MAX_RENDER_PROPS];
 } _render_props;
 
-// raycasting angles
-#define RAYCAST_PRECISION 256
-typedef struct {
-    int distance;
-    float angle;
-} Ray;
-static Ray _rays[RAYCAST_PRECISION] = {0};
+// active slices + course generator
+struct GroundContext {
+    GroundParams params;
+    // track generator
+    TrackDirector director;
+    // 
+    int slice_id;
+    // start slice index
+    int plyr_z_index;
+    int max_pz;
+    float slice_y;
+    float noise_y_offset;
+    // ring buffer of slices (slice 0 at head)
+    // visible slices followed by pre-generated slices
+    int head;
+    // number of pre-generated slices
+    int ready;
+    // accumulated vertical offset (slices y are relative to it)
+    float y_offset;
+    GroundSlice* slices[GROUND_SLICES];
+    // shading bands offset (incremented as slices scroll)
+    int z_offset;
+    // average slice generation time (seconds)
+    float slice_cost;
+    // coins around player (see get_props)
+    struct {
+        int n;
+        PropInfo props[MAX_PROPS];
+    } props_info;
+    // slices storage
+    GroundSlice slices_buffer[GROUND_SLICES];
+};
+
+// slice j (0: nearest)
+static inline GroundSlice* get_slice(const GroundContext* ctx, const int j) {
+#ifdef GROUND_EAGER_REBASE
+    return ctx->slices[j];
+#else
+    int k = ctx->head + j;
+    if (k >= GROUND_SLICES) k -= GROUND_SLICES;
+    return ctx->slices[k];
+#endif
+}
+
+// slice altitude (ground space)
+static inline float get_slice_y(const GroundContext* ctx, const GroundSlice* s) {
+    return s->y - ctx->y_offset;
+}
+
+#ifndef GROUND_EAGER_REBASE
+// apply vertical offset to all slices
+static void rebase_slices(GroundContext* ctx) {
+    for (int i = 0; i < GROUND_SLICES; ++i) {
+        ctx->slices[i]->y -= ctx->y_offset;
+    }
+    ctx->y_offset = 0.f;
+}
+#endif
 
-// global buffer to store slices
-static GroundSlice _slices_buffer[GROUND_HEIGHT] = {0};
-// active ground
-static Ground _ground;
+// slice generation budget (seconds per frame, 0: generate on demand)
+// default: 1ms
+#define GROUND_GENERATION_BUDGET 1000
+static float _generation_budget = GROUND_GENERATION_BUDGET / 1000000.f;
 
-static GroundParams active_params;
+// active render options
+static int _render_flags = 0;
 
 // 16 32 * 4 bytes bitmaps
 uint32_t _dithers[32 * 16];
@@ -137,24 +206,22 @@ static uint32_t* _backgrounds[61] = {0};
 static int _backgrounds_heights[61] = {0};
 
 // compute normal and assign material for faces
-static int _z_offset = 0;
-static void mesh_slice(int j) {
-    _z_offset++;
-    GroundSlice* s0 = _ground.slices[j];
-    GroundSlice* s1 = _ground.slices[j + 1];
+// base_y: ground space origin (faces are computed in the same space as on-demand generation)
+static void mesh_slice(GroundSlice* s0, const GroundSlice* s1, const float base_y) {
+    const float sy0 = s0->y - base_y, sy1 = s1->y - base_y;
 
     // base slope normal
-    Point3d sn = { .x = 0, .y = GROUND_CELL_SIZE, .z = s0->y - s1->y };
+    Point3d sn = { .x = 0, .y = GROUND_CELL_SIZE, .z = sy0 - sy1 };
     v_normz(&sn);
 
     for (int i = 0; i < GROUND_WIDTH - 1; i++) {
-        const float y0 = s0->heights[i] + s0->y;
+        const float y0 = s0->heights[i] + sy0;
         // v1-v0
-        const Point3d u1 = { .v = {(float)GROUND_CELL_SIZE, s0->heights[i + 1] + s0->y - y0, 0.f} };
+        const Point3d u1 = { .v = {(float)GROUND_CELL_SIZE, s0->heights[i + 1] + sy0 - y0, 0.f} };
         // v2-v0
-        const Point3d u2 = { .v = {(float)GROUND_CELL_SIZE, s1->heights[i + 1] + s1->y - y0, (float)GROUND_CELL_SIZE} };
+        const Point3d u2 = { .v = {(float)GROUND_CELL_SIZE, s1->heights[i + 1] + sy1 - y0, (float)GROUND_CELL_SIZE} };
         // v3-v0
-        const Point3d u3 = { .v = {0.f, s1->heights[i] + s1->y - y0, (float)GROUND_CELL_SIZE} };
+        const Point3d u3 = { .v = {0.f, s1->heights[i] + sy1 - y0, (float)GROUND_CELL_SIZE} };
 
         GroundFace* f0 = &s0->tiles[i].f0;
         GroundFace* f1 = &s0->tiles[i].f1;
@@ -172,35 +239,47 @@ static void mesh_slice(int j) {
     }
 }
 
-static void make_slice(GroundSlice* slice, float y) {
+// y: target altitude relative to base_y (ground space origin)
+static void make_slice(GroundContext* ctx, GroundSlice* slice, float y, const float base_y) {
     static int trees[] = { PROP_TREE0,PROP_TREE0,PROP_TREE1,PROP_TREE1,PROP_TREE2,PROP_TREE3,PROP_TREE3,PROP_TREE4,PROP_TREE4,PROP_TREE4,PROP_TREE5,PROP_TREE5,PROP_TREE5,PROP_LOG };
     static int num_trees = sizeof(trees) / sizeof(PROP_TREE0);
 
+    // capture generator state
+    slice->gen.slice_id = ctx->slice_id;
+    slice->gen.slice_y = ctx->slice_y;
+    slice->gen.noise_y_offset = ctx->noise_y_offset;
+    save_tracks(&ctx->director, &slice->gen.tracks);
+    slice->gen_y = y;
+
     // smooth altitude changes
-    _ground.slice_y = lerpf(_ground.slice_y, y, 0.2f);
-    y = _ground.slice_y;
-    // capture height
-    slice->y = y;
+    ctx->slice_y = lerpf(ctx->slice_y, y, 0.2f);
+    y = ctx->slice_y;
+    // capture height (relative to ground offset)
+    // note: snapped to 1/256 so that offsetting is exact
+    slice->y = roundf(y * SLICE_Y_SCALE) / SLICE_Y_SCALE + base_y;
+    slice->gen_base_dy = base_y - slice->y;
     slice->tracks_mask = 0;
 
-    update_tracks();
+    // random rolls are keyed by slice id (see rand_r.h)
+    const int seed = ctx->params.r_seed, slice_id = ctx->slice_id + 1;
+    update_tracks(&ctx->director, slice_id);
 
     // generate height
     uint32_t shadow_mask = 0;
+    perlin2d_row(ctx->noise_y_offset, 0.25f, 4, slice->heights);
     for (int i = 0; i < GROUND_WIDTH; ++i) {
-        slice->heights[i] = (perlin2d((16.f * i) / GROUND_WIDTH, _ground.noise_y_offset, 0.25f, 4)) * 4.f * active_params.slope;
-        
+        slice->heights[i] = slice->heights[i] * 4.f * ctx->params.slope;
     }
     for (int i = 0; i < GROUND_WIDTH; ++i) {
         slice->tiles[i].prop_id = 0;
     }
 
-    _ground.noise_y_offset += (active_params.slope + randf_seeded()) / 4.f;
+    ctx->noise_y_offset += (ctx->params.slope + randf_at(seed, slice_id, 0, RAND_SLICE_NOISE)) / 4.f;
 
     int imin = 3, imax = GROUND_WIDTH - 3;
     float main_track_x = GROUND_CELL_SIZE * (imin + imax) / 2.f;
     int is_checkpoint = 0;
-    Tracks* tracks = _ground.tracks;    
+    Tracks* tracks = &ctx->director.tracks;    
     for (int k = 0; k < tracks->n; ++k) {
         Track* t = &tracks->tracks[k];
         if (!t->is_dead) {
@@ -210,9 +289,9 @@ static void make_slice(GroundSlice* slice, float y) {
                 // random filling
                 for (int i = 3; i < i0 - 1; i++) {
                     GroundTile* tile = &slice->tiles[i];
-                    if (randf_seeded() > active_params.props_rate) {
-                        tile->prop_id = trees[randi_seeded(num_trees)];
-                        tile->prop_t = randf_seeded();
+                    if (randf_at(seed, slice_id, i, RAND_PROP) > ctx->params.props_rate) {
+                        tile->prop_id = trees[randi_at(num_trees, seed, slice_id, i, RAND_PROP_ID)];
+                        tile->prop_t = randf_at(seed, slice_id, i, RAND_PROP_T);
                         // slight shading under trees
                         shadow_mask |= 0x3 << i;
                     }
@@ -220,9 +299,9 @@ static void make_slice(GroundSlice* slice, float y) {
 
                 for (int i = i1 + 1; i < GROUND_WIDTH - 2; i++) {
                     GroundTile* tile = &slice->tiles[i];
-                    if (randf_seeded() > active_params.props_rate) {
-                        tile->prop_id = trees[randi_seeded(num_trees)];
-                        tile->prop_t = randf_seeded();
+                    if (randf_at(seed, slice_id, i, RAND_PROP) > ctx->params.props_rate) {
+                        tile->prop_id = trees[randi_at(num_trees, seed, slice_id, i, RAND_PROP_ID)];
+                        tile->prop_t = randf_at(seed, slice_id, i, RAND_PROP_T);
                         // slight shading under trees
                         shadow_mask |= 0x3 << i;
                     }
@@ -236,7 +315,7 @@ static void make_slice(GroundSlice* slice, float y) {
                     // remove props from track
                     int prop_id = 0;
                     float prop_t = 0.5f;
-                    switch (_ground.tracks->pattern[i]) {
+                    switch (ctx->director.tracks.pattern[i]) {
                         // B: balloon (lua)
                         // K: skidoo (lua)
                     case 'A': prop_id = PROP_PLAYDATE; break;
@@ -244,7 +323,7 @@ static void make_slice(GroundSlice* slice, float y) {
                     case 'W': prop_id = PROP_WARNING; break;
                     case 'R': prop_id = PROP_ROCK; break;
                     case 'P': prop_id = PROP_SNOWPLOW; break;
-                    case 'M': prop_id = PROP_COW; prop_t = randf_seeded(); break;
+                    case 'M': prop_id = PROP_COW; prop_t = randf_at(seed, slice_id, i, RAND_PROP_T); break;
                     case 'J': prop_id = PROP_JUMPPAD; break;
                     case 'S': prop_id = PROP_START; break;
                     case 'D': prop_id = PROP_GORIGHT; break;
@@ -253,14 +332,14 @@ static void make_slice(GroundSlice* slice, float y) {
                         // hole
                     case 'O': slice->heights[i] = -4.f; break;
                         // geump :)
-                    case '1': slice->heights[i] += 0.75f * active_params.slope; break;
-                    case '2': slice->heights[i] += 1.f * active_params.slope; break;
-                    case '3': slice->heights[i] += 1.5f * active_params.slope; break;
-                    case '4': slice->heights[i] += 2.5f * active_params.slope; break;
-                    case '5': slice->heights[i] += 3.5f * active_params.slope; break;
+                    case '1': slice->heights[i] += 0.75f * ctx->params.slope; break;
+                    case '2': slice->heights[i] += 1.f * ctx->params.slope; break;
+                    case '3': slice->heights[i] += 1.5f * ctx->params.slope; break;
+                    case '4': slice->heights[i] += 2.5f * ctx->params.slope; break;
+                    case '5': slice->heights[i] += 3.5f * ctx->params.slope; break;
                     case 'T':
-                        prop_id = trees[randi_seeded(num_trees)];
-                        prop_t = randf_seeded();
+                        prop_id = trees[randi_at(num_trees, seed, slice_id, i, RAND_PROP_ID)];
+                        prop_t = randf_at(seed, slice_id, i, RAND_PROP_T);
                         // tree shading
                         shadow_mask |= 0x3 << i;
                         break;
@@ -275,8 +354,8 @@ static void make_slice(GroundSlice* slice, float y) {
                 }
             }
             else {
-                if ((_ground.slice_id & 3) == 0 && randf() > 0.75f) {
-                    const i = (i0 + i1) / 2;
+                const int i = (i0 + i1) / 2;
+                if ((ctx->slice_id & 3) == 0 && randf_at(seed, slice_id, i, RAND_COIN) > 0.75f) {
                     slice->tiles[i].prop_id = PROP_COIN;
                     slice->tiles[i].prop_t = 0.5f;
                 }
@@ -296,9 +375,9 @@ static void make_slice(GroundSlice* slice, float y) {
     slice->is_checkpoint = is_checkpoint;
 
     // side walls
-    slice->heights[0] = 15.f + 5.f * randf_seeded();
-    slice->heights[GROUND_WIDTH - 1] = 15.f + 5.f * randf_seeded();
-    if (active_params.tight_mode) {
+    slice->heights[0] = 15.f + 5.f * randf_at(seed, slice_id, 0, RAND_WALL);
+    slice->heights[GROUND_WIDTH - 1] = 15.f + 5.f * randf_at(seed, slice_id, GROUND_WIDTH - 1, RAND_WALL);
+    if (ctx->params.tight_mode) {
         for (int i = 1; i < imin - 1; i++) {
             slice->heights[i] = slice->heights[0];
             slice->tiles[i].prop_id = 0;
@@ -321,10 +400,12 @@ static void make_slice(GroundSlice* slice, float y) {
     // apply props shadows
     slice->tracks_mask |= shadow_mask;
     //  + nice transition
-    slice->heights[imin] = lerpf(slice->heights[imin - 1], slice->heights[imin], lerpf(0.8f,0.666f,randf_seeded()));
-    slice->heights[imax] = lerpf(slice->heights[imax + 1], slice->heights[imax], lerpf(0.666f,0.8f,randf_seeded()));
+    slice->heights[imin] = lerpf(slice->heights[imin - 1], slice->heights[imin], lerpf(0.8f,0.666f,randf_at(seed, slice_id, 0, RAND_WALL_BLEND)));
+    slice->heights[imax] = lerpf(slice->heights[imax + 1], slice->heights[imax], lerpf(0.666f,0.8f,randf_at(seed, slice_id, 1, RAND_WALL_BLEND)));
 
-    _ground.slice_id++;
+    ctx->slice_id = slice_id;
+    slice->slice_id = slice_id;
+    memcpy(slice->pattern, ctx->director.tracks.pattern, TRACK_PATTERN_WIDTH);
 
     /*
     char buffer[33];
@@ -333,39 +414,167 @@ static void make_slice(GroundSlice* slice, float y) {
     for (int i = 0; i < 32; i++) {        
         buffer[i] = '0' + slice->tiles[i].prop_id;
     }
-    pd->system->logToConsole("%s [%i %i]", _ground.tracks->pattern, imin, imax);
+    pd->system->logToConsole("%s [%i %i]", ctx->director.tracks.pattern, imin, imax);
     */
 }
 
-void make_ground(GroundParams params, TrackPatterns* patterns) {
-    active_params = params;
-    
-    // init random seed
-    rand_r_init(params.r_seed);
+// generate next slice after the visible window (+ ready slices)
+static void prefetch_slice(GroundContext* ctx) {
+    // ground space when slice enters view (e.g. first visible slice at 0)
+    const float base_y = get_slice(ctx, ctx->ready)->y;
+    GroundSlice* prev_slice = get_slice(ctx, GROUND_HEIGHT - 1 + ctx->ready);
+    GroundSlice* slice = get_slice(ctx, GROUND_HEIGHT + ctx->ready);
+    // use previous baseline
+    make_slice(ctx, slice, prev_slice->y - base_y - ctx->params.slope * (randf_at(ctx->params.r_seed, ctx->slice_id + 1, 0, RAND_SLICE_Y) + 0.5f), base_y);
+    mesh_slice(prev_slice, slice, base_y);
+    ctx->ready++;
+}
+
+// fill pre-generated slices within time budget
+static void prefetch_slices(GroundContext* ctx) {
+    if (ctx->ready == GROUND_PREFETCH || _generation_budget <= 0.f) return;
+
+    const float t0 = pd->system->getElapsedTime();
+    float t = t0;
+    while (ctx->ready < GROUND_PREFETCH && t - t0 + ctx->slice_cost <= _generation_budget) {
+        prefetch_slice(ctx);
+        const float t1 = pd->system->getElapsedTime();
+        ctx->slice_cost = lerpf(ctx->slice_cost, t1 - t, 0.1f);
+        t = t1;
+    }
+}
+
+void set_generation_budget(const int us) {
+    _generation_budget = us / 1000000.f;
+}
+
+GroundContext* create_ground_context() {
+    GroundContext* ctx = lib3d_malloc(sizeof(GroundContext));
+    memset(ctx, 0, sizeof(GroundContext));
+    return ctx;
+}
+
+void destroy_ground_context(GroundContext* ctx) {
+    lib3d_free(ctx);
+}
+
+const GroundParams* get_ground_params(const GroundContext* ctx) {
+    return &ctx->params;
+}
 
-    // reset global params
-    _ground.slice_id = 0;
-    _ground.slice_y = 0;
-    _ground.noise_y_offset = 16.f * randf_seeded();
-    _ground.plyr_z_index = (GROUND_HEIGHT / 2) - 1;
-    _ground.max_pz = 0;
+void make_ground(GroundContext* ctx, GroundParams params, TrackPatterns* patterns) {
+    ctx->params = params;
 
+    // reset generator
+    ctx->slice_id = 0;
+    ctx->slice_y = 0;
+    ctx->noise_y_offset = 16.f * randf_at(params.r_seed, 0, 0, RAND_SLICE_NOISE);
+    ctx->plyr_z_index = (GROUND_HEIGHT / 2) - 1;
+    ctx->max_pz = 0;
+    ctx->head = 0;
+    ctx->ready = 0;
+    ctx->y_offset = 0.f;
+    ctx->z_offset = 0;
 
     // init track generator
-    make_tracks(4 * GROUND_CELL_SIZE, (GROUND_WIDTH - 5)*GROUND_CELL_SIZE, params, &_ground.tracks);
+    make_tracks(&ctx->director, 4 * GROUND_CELL_SIZE, (GROUND_WIDTH - 5)*GROUND_CELL_SIZE, params);
 
+    for (int i = 0; i < GROUND_SLICES; ++i) {
+        ctx->slices[i] = &ctx->slices_buffer[i];
+    }
+    const float t0 = pd->system->getElapsedTime();
     for (int i = 0; i < GROUND_HEIGHT; ++i) {
         // reset slices
-        _ground.slices[i] = &_slices_buffer[i];
-        make_slice(_ground.slices[i], -i * params.slope);
-        memcpy(patterns->pattern[i],_ground.tracks->pattern, TRACK_PATTERN_WIDTH);
+        make_slice(ctx, get_slice(ctx, i), -i * params.slope, 0.f);
+        memcpy(patterns->pattern[i],ctx->director.tracks.pattern, TRACK_PATTERN_WIDTH);
     }
     for (int i = 0; i < GROUND_HEIGHT - 1; ++i) {
-        mesh_slice(i);
+        ctx->z_offset++;
+        mesh_slice(get_slice(ctx, i), get_slice(ctx, i + 1), 0.f);
+    }
+    ctx->slice_cost = (pd->system->getElapsedTime() - t0) / GROUND_HEIGHT;
+}
+
+// ground snapshot (POD)
+// generator state before the first visible slice + inputs of every generated slice
+struct GroundState {
+    int version;
+    int size;
+    GroundParams params;
+    GeneratorState gen;
+    int max_pz;
+    int z_offset;
+    // number of pre-generated slices
+    int ready;
+    struct {
+        float y;
+        // ground space
+        float base_y;
+    } slices[GROUND_SLICES];
+};
+
+int get_ground_state_size() {
+    return sizeof(GroundState);
+}
+
+void save_ground_state(const GroundContext* ctx, GroundState* out) {
+    memset(out, 0, sizeof(GroundState));
+    out->version = GROUND_STATE_VERSION;
+    out->size = sizeof(GroundState);
+    out->params = ctx->params;
+    out->gen = get_slice(ctx, 0)->gen;
+    out->max_pz = ctx->max_pz;
+    out->z_offset = ctx->z_offset;
+    out->ready = ctx->ready;
+    for (int j = 0; j < GROUND_HEIGHT + ctx->ready; ++j) {
+        const GroundSlice* s = get_slice(ctx, j);
+        out->slices[j].y = s->gen_y;
+        out->slices[j].base_y = s->y + s->gen_base_dy - ctx->y_offset;
     }
 }
 
-void update_ground(const Point3d p, int* slice_id, TrackPattern* pattern, Point3d* offset) {
+int restore_ground_state(GroundContext* ctx, const GroundState* state, TrackPatterns* patterns) {
+    if (state->version != GROUND_STATE_VERSION || state->size != sizeof(GroundState)) {
+        pd->system->logToConsole("Invalid ground state version: %i (expected: %i)", state->version, GROUND_STATE_VERSION);
+        return 0;
+    }
+    if (state->ready < 0 || state->ready > GROUND_PREFETCH) {
+        pd->system->logToConsole("Invalid ground state: %i pre-generated slices (max: %i)", state->ready, GROUND_PREFETCH);
+        return 0;
+    }
+    ctx->params = state->params;
+
+    ctx->plyr_z_index = (GROUND_HEIGHT / 2) - 1;
+    ctx->max_pz = state->max_pz;
+    ctx->head = 0;
+    ctx->ready = 0;
+    ctx->y_offset = 0.f;
+    for (int i = 0; i < GROUND_SLICES; ++i) {
+        ctx->slices[i] = &ctx->slices_buffer[i];
+    }
+
+    // replay generation from first visible slice
+    ctx->slice_id = state->gen.slice_id;
+    ctx->slice_y = state->gen.slice_y;
+    ctx->noise_y_offset = state->gen.noise_y_offset;
+    restore_tracks(&ctx->director, &state->gen.tracks);
+
+    const int n = GROUND_HEIGHT + state->ready;
+    for (int j = 0; j < n; ++j) {
+        make_slice(ctx, get_slice(ctx, j), state->slices[j].y, state->slices[j].base_y);
+    }
+    for (int j = 0; j < n - 1; ++j) {
+        mesh_slice(get_slice(ctx, j), get_slice(ctx, j + 1), state->slices[j + 1].base_y);
+    }
+    for (int i = 0; i < GROUND_HEIGHT; ++i) {
+        memcpy(patterns->pattern[i], get_slice(ctx, i)->pattern, TRACK_PATTERN_WIDTH);
+    }
+    ctx->ready = state->ready;
+    ctx->z_offset = state->z_offset;
+    return 1;
+}
+
+void update_ground(GroundContext* ctx, const Point3d p, int* slice_id, TrackPattern* pattern, Point3d* offset) {
     // TODO: FIX!!!
     // prevent going up slope!
     float pz = p.z;
@@ -373,50 +582,60 @@ void update_ground(const Point3d p, int* slice_id, TrackPattern* pattern, Point3
     *offset = (Point3d){ .v = {0} };
 
     // handles faster than 1 tile moves
-    while ( pz/ GROUND_CELL_SIZE > _ground.plyr_z_index ) {
+    while ( pz/ GROUND_CELL_SIZE > ctx->plyr_z_index ) {
         // shift back
         pz -= GROUND_CELL_SIZE;
         offset->z -= GROUND_CELL_SIZE;
-        _ground.max_pz -= GROUND_CELL_SIZE;
-        GroundSlice* old_slice = _ground.slices[0];
-        const float old_y = old_slice->y;
+        ctx->max_pz -= GROUND_CELL_SIZE;
+        // out of pre-generated slices?
+        if (!ctx->ready) prefetch_slice(ctx);
+
+        GroundSlice* old_slice = get_slice(ctx, 0);
+        const float old_y = get_slice_y(ctx, old_slice);
         offset->y -= old_y;
+#ifdef GROUND_EAGER_REBASE
         // drop slice 0
-        for (int i = 1; i < GROUND_HEIGHT; ++i) {
-            _ground.slices[i - 1] = _ground.slices[i];
-            _ground.slices[i - 1]->y -= old_y;
+        for (int i = 1; i < GROUND_SLICES; ++i) {
+            ctx->slices[i - 1] = ctx->slices[i];
+            ctx->slices[i - 1]->y -= old_y;
         }
         // move shifted slices back to top
-        _ground.slices[GROUND_HEIGHT - 1] = old_slice;        
-
-        // use previous baseline
-        make_slice(old_slice, _ground.slices[GROUND_HEIGHT - 2]->y - active_params.slope * (randf_seeded() + 0.5f));
-        mesh_slice(GROUND_HEIGHT - 2);
+        ctx->slices[GROUND_SLICES - 1] = old_slice;        
+#else
+        // drop slice 0 (next ready slice enters view)
+        ctx->y_offset += old_y;
+        if (++ctx->head == GROUND_SLICES) ctx->head = 0;
+        if (fabsf(ctx->y_offset) > GROUND_MAX_Y_OFFSET) rebase_slices(ctx);
+#endif
+        ctx->ready--;
+        ctx->z_offset++;
     }
     // update y offset
-    if (pz > _ground.max_pz) {
-        _ground.max_pz = (int)pz;
+    if (pz > ctx->max_pz) {
+        ctx->max_pz = (int)pz;
     }
 
-    // update particles (inc. world shifting)
-    update_particles(*offset);
+    // generate ahead
+    prefetch_slices(ctx);
 
-    *slice_id = _ground.slice_id;
-    memcpy(pattern,_ground.tracks->pattern, TRACK_PATTERN_WIDTH);
+    // last visible slice
+    const GroundSlice* last_slice = get_slice(ctx, GROUND_HEIGHT - 1);
+    *slice_id = last_slice->slice_id;
+    memcpy(pattern, last_slice->pattern, TRACK_PATTERN_WIDTH);
 }
 
-void get_start_pos(Point3d* out) {
+void get_start_pos(const GroundContext* ctx, Point3d* out) {
     *out = (Point3d){.v = {
-        _ground.slices[_ground.plyr_z_index]->center, 
+        get_slice(ctx, ctx->plyr_z_index)->center, 
         0,
-        (float)_ground.plyr_z_index * GROUND_CELL_SIZE} };
+        (float)ctx->plyr_z_index * GROUND_CELL_SIZE} };
     Point3d n;
     float y;
-    get_face(*out, &n, &y);
+    get_face(ctx, *out, &n, &y);
     out->y = y;
 }
 
-int get_face(const Point3d pos, Point3d* nout, float* yout) {
+int get_face(const GroundContext* ctx, const Point3d pos, Point3d* nout, float* yout) {
     // z slice
     int i = (int)(pos.x / GROUND_CELL_SIZE), j = (int)(pos.z / GROUND_CELL_SIZE);
     // outside ground?
@@ -424,7 +643,7 @@ int get_face(const Point3d pos, Point3d* nout, float* yout) {
         return 0;
     }
 
-    GroundSlice* s0 = _ground.slices[j];
+    GroundSlice* s0 = get_slice(ctx, j);
     GroundTile* t0 = &s0->tiles[i];
     GroundFace* f0 = &t0->f0;
     GroundFace* f1 = &t0->f1;
@@ -434,7 +653,7 @@ int get_face(const Point3d pos, Point3d* nout, float* yout) {
 
     // intersection point
     Point3d ptOnFace;
-    make_v((Point3d) { .v = {(float)i * GROUND_CELL_SIZE, s0->heights[i] + s0->y, (float)j * GROUND_CELL_SIZE} }, pos, & ptOnFace);
+    make_v((Point3d) { .v = {(float)i * GROUND_CELL_SIZE, s0->heights[i] + get_slice_y(ctx, s0), (float)j * GROUND_CELL_SIZE} }, pos, & ptOnFace);
          
     // height
     *yout = pos.y - v_dot(ptOnFace, f->n) / f->n.y;
@@ -447,14 +666,14 @@ int get_face(const Point3d pos, Point3d* nout, float* yout) {
 }
 
 // get slice extents
-void get_track_info(const Point3d pos, float* xmin, float* xmax, float* z, int* checkpoint, float* angleout) {
+void get_track_info(const GroundContext* ctx, const Point3d pos, float* xmin, float* xmax, float* z, int* checkpoint, float* angleout) {
     int j = (int)(pos.z / GROUND_CELL_SIZE);
     if (j < 0 || j >= GROUND_HEIGHT) {
         pd->system->error("Invalid z position: %f", pos.z);
         return;
     }
 
-    const GroundSlice* s0 = _ground.slices[j];
+    const GroundSlice* s0 = get_slice(ctx, j);
     *xmin = (float)(s0->extents[0] * GROUND_CELL_SIZE);
     *xmax = (float)(s0->extents[1] * GROUND_CELL_SIZE);
     // activate checkpoint at middle of cell
@@ -465,9 +684,9 @@ void get_track_info(const Point3d pos, float* xmin, float* xmax, float* z, int*
     // find nearest checkpoint
     *angleout = 0.f;
     if (j + 2 < GROUND_HEIGHT) {
-        float x = _ground.slices[j + 2]->center, y = 2;
+        float x = get_slice(ctx, j + 2)->center, y = 2;
         for (int k = j + 2; k < j + 10 && k < GROUND_HEIGHT; ++k) {
-            GroundSlice* s = _ground.slices[k];
+            GroundSlice* s = get_slice(ctx, k);
             if (s->is_checkpoint) {
                 x = s->center;
                 y = (float)(k - j);
@@ -479,29 +698,29 @@ void get_track_info(const Point3d pos, float* xmin, float* xmax, float* z, int*
     }
 }
 
-void get_props(Point3d pos, PropInfo** info, int* nout) {
+void get_props(GroundContext* ctx, Point3d pos, PropInfo** info, int* nout) {
     const int ii = (int)(pos.x / GROUND_CELL_SIZE);
     int i0 = ii - 4, i1 = ii + 4;
     if (i0 < 0) i0 = 0;
     if (i1 > GROUND_WIDTH) i1 = GROUND_WIDTH;
 
     const int j0 = (int)(pos.z / GROUND_CELL_SIZE) + 1;
-    _props_info.n = 0;
-    for (int j = j0; j < j0 + 3 && _props_info.n < MAX_PROPS; ++j) {
-        const GroundSlice* s0 = _ground.slices[j];
-        const GroundSlice* s1 = _ground.slices[j + 1];
-        for (int i = i0; i < i1 && _props_info.n < MAX_PROPS; ++i) {
+    ctx->props_info.n = 0;
+    for (int j = j0; j < j0 + 3 && ctx->props_info.n < MAX_PROPS; ++j) {
+        const GroundSlice* s0 = get_slice(ctx, j);
+        const GroundSlice* s1 = get_slice(ctx, j + 1);
+        for (int i = i0; i < i1 && ctx->props_info.n < MAX_PROPS; ++i) {
             const GroundTile* t0 = &s0->tiles[i];
             int prop_id = t0->prop_id;
             if (prop_id == PROP_COIN) {
-                PropInfo* info = &_props_info.props[_props_info.n++];
+                PropInfo* info = &ctx->props_info.props[ctx->props_info.n++];
                 info->type = prop_id;
                 v_lerp(
                     (Point3d) {
-                    .v = { (float)i * GROUND_CELL_SIZE,         s0->heights[i] + s0->y,       (float)j * GROUND_CELL_SIZE }
+                    .v = { (float)i * GROUND_CELL_SIZE,         s0->heights[i] + get_slice_y(ctx, s0),       (float)j * GROUND_CELL_SIZE }
                 },
                     (Point3d) {
-                    .v = { (float)(i + 1) * GROUND_CELL_SIZE,   s1->heights[i + 1] + s1->y,   (float)(j + 1) * GROUND_CELL_SIZE }
+                    .v = { (float)(i + 1) * GROUND_CELL_SIZE,   s1->heights[i + 1] + get_slice_y(ctx, s1),   (float)(j + 1) * GROUND_CELL_SIZE }
                 },
                         t0->prop_t,
                         & info->pos);
@@ -509,18 +728,18 @@ void get_props(Point3d pos, PropInfo** info, int* nout) {
             }
         }
     }
-    *nout = _props_info.n;
-    *info = _props_info.props;
+    *nout = ctx->props_info.n;
+    *info = ctx->props_info.props;
 }
 
 // clear checkpoint
-void clear_checkpoint(const Point3d pos) {
+void clear_checkpoint(GroundContext* ctx, const Point3d pos) {
     int j = (int)(pos.z / GROUND_CELL_SIZE);
-    GroundSlice* s0 = _ground.slices[j];
+    GroundSlice* s0 = get_slice(ctx, j);
     s0->is_checkpoint = 0;
 }
 
-void collide(const Point3d pos, float radius, int* hit_type)
+void collide(GroundContext* ctx, const Point3d pos, float radius, int* hit_type)
 {
     // default
     *hit_type = 0;
@@ -546,7 +765,7 @@ void collide(const Point3d pos, float radius, int* hit_type)
     float tilez = (float)(j0 - 1) * GROUND_CELL_SIZE;
     for (int j = j0 - 1; j < j0 + 2; j++, tilez += GROUND_CELL_SIZE) {
         if (j >= 0 && j < GROUND_HEIGHT) {
-            GroundSlice* s0 = _ground.slices[j];
+            GroundSlice* s0 = get_slice(ctx, j);
             float tilex = (float)(i0 - 1) * GROUND_CELL_SIZE;
             for (int i = i0 - 1; i < i0 + 2; i++, tilex += GROUND_CELL_SIZE) {
                 if (i >= 0 && i < GROUND_WIDTH) {
@@ -558,8 +777,8 @@ void collide(const Point3d pos, float radius, int* hit_type)
                         if (props->flags & PROP_FLAG_HITABLE) {
 
                             // generate vertex
-                            Point3d v0 = (Point3d){ .v = {(float)tilex,s0->heights[i] + s0->y,(float)tilez} };
-                            Point3d v2 = (Point3d){ .v = {(float)(tilex + GROUND_CELL_SIZE),s0->heights[i + 1] + s0->y,(float)(tilez + GROUND_CELL_SIZE)} };
+                            Point3d v0 = (Point3d){ .v = {(float)tilex,s0->heights[i] + get_slice_y(ctx, s0),(float)tilez} };
+                            Point3d v2 = (Point3d){ .v = {(float)(tilex + GROUND_CELL_SIZE),s0->heights[i + 1] + get_slice_y(ctx, s0),(float)(tilez + GROUND_CELL_SIZE)} };
                             Point3d res;
                             v_lerp(v0, v2, t0->prop_t, &res);
                             make_v(pos, res, &res);
@@ -807,18 +1026,11 @@ void ground_init(PlaydateAPI* playdate) {
 
     pd->system->logToConsole("Load async tasks #: %i", _work.n);
 
-    // raycasting angles
-    for(int i=0;i<RAYCAST_PRECISION;++i) {
-        // 1.5f to overshoot 
-        float t = 1.5f * (((float)i) / RAYCAST_PRECISION - 0.5f);
-        const float angle = atan2f(MAX_TILE_DIST, MAX_TILE_DIST * t * 2.f) - PI / 2.f;
-        // using a 24:8 "fixed" value
-        const int dist_max = (int)((MAX_TILE_DIST << 8) / cosf(angle));
-        _rays[i] = (Ray){
-            .distance = dist_max * dist_max,
-            .angle = angle
-        };            
-    }
+    // dither tables referenced by raster captures
+    capture_register_table(_dithers, sizeof(_dithers));
+    capture_register_table(_ordered_dithers, sizeof(_ordered_dithers));
+    capture_register_table(_dither_ramps, sizeof(_dither_ramps));
+    capture_register_table(_danger_dither_ramps, sizeof(_danger_dither_ramps));
 
     // props config (todo: get from lua?)
 
@@ -855,8 +1067,26 @@ void ground_init(PlaydateAPI* playdate) {
 
     // bind all props to the corresponding 3d model
     for (int i = 0; i < NEXT_PROP_ID; ++i) {
-        _props_properties[i].flags |= PROP_FLAG_3D;
-        _props_properties[i].model = &three_d_models[i];
+        PropProperties* props = &_props_properties[i];
+        props->flags |= PROP_FLAG_3D;
+        props->model = &three_d_models[i];
+        // model bounds
+        props->bounds_radius = 0.f;
+        props->bounds_y = (FloatRange){ .min = 0.f, .max = 0.f };
+        // note: last prop id has no model
+        if (i >= sizeof(three_d_models) / sizeof(ThreeDModel)) continue;
+        props->bounds_y = (FloatRange){ .min = FLT_MAX, .max = -FLT_MAX };
+        for (int j = 0; j < props->model->face_count; ++j) {
+            const ThreeDFace* f = &props->model->faces[j];
+            const int n = f->flags & FACE_FLAG_QUAD ? 4 : 3;
+            for (int k = 0; k < n; ++k) {
+                const Point3d* v = &f->vertices[k];
+                const float r = sqrtf(v->x * v->x + v->z * v->z);
+                if (r > props->bounds_radius) props->bounds_radius = r;
+                if (v->y < props->bounds_y.min) props->bounds_y.min = v->y;
+                if (v->y > props->bounds_y.max) props->bounds_y.max = v->y;
+            }
+        }
     }
 }
 
@@ -883,9 +1113,12 @@ int ground_load_assets_async() {
 #define SHADING_CONTRAST 1.5f
 
 // cache entry (transformed point in camera space)
+// screen space projection is done once, on first use by a non clipped tile
 typedef struct {
     int outcode;
     Point3du p;
+    // vertex arena handle (-1: not projected)
+    int vertex;
 } CameraPoint;
 
 typedef struct {
@@ -923,31 +1156,40 @@ static int z_poly_clip(const float z, const float flip, Point3du* in, int n, Poi
     return nout;
 }
 
-static void draw_tile(Drawable* drawable, uint8_t* bitmap) {
-    DrawableFace* face = &drawable->face;
-
-    const int n = face->n;
-    Point3du* pts = face->pts;
-    for (int i = 0; i < n; i++) {
-        // project 
-        const float w = 1.f / pts[i].z;
-        pts[i].x = 199.5f + 199.5f * w * pts[i].x;
-        pts[i].y = 119.5f - 199.5f * w * pts[i].y;
+// far distance attenuation of a tile point
+static float get_tile_fade(const float z) {
+    const float dist = Z_FAR - z - 2*GROUND_CELL_SIZE;
+    float fade = dist / (2.0f * GROUND_CELL_SIZE);
+    if (fade > 1.f) fade = 1.f;
+    if (fade < 0.f) fade = 0.f;
+    return fade;
+}
 
+// shaded tile points from vertex arena
+static void get_tile_points(const DrawableFace* face, const int is_danger, Point3du* pts) {
+    for (int i = 0; i < face->n; i++) {
+        const DrawableVertex* v = DRAWABLE_VERTEX(face->v[i]);
         // works ok
-        float shading = face->material == GROUNDFACE_FLAG_SNOW ? 4.0f * pts[i].u + 8.f * w : 6.0f + 4.0f * pts[i].u + 4.f * w;
+        float shading = face->material == GROUNDFACE_FLAG_SNOW ? 4.0f * v->p.u + 8.f * v->w : (is_danger ? 4.0f : 6.0f) + 4.0f * v->p.u + 4.f * v->w;
         // attenuation
-        shading *= pts[i].light;
+        shading *= v->p.light * face->light;
         if (shading > 15.f) shading = 15.f;
         if (shading < 0.f) shading = 0.f;
 
-        float dist = Z_FAR - pts[i].z - 2*GROUND_CELL_SIZE;
-        float dist_shading = dist / (2.0f * GROUND_CELL_SIZE);
-        if (dist_shading > 1.f) dist_shading = 1.f;
-        if (dist_shading < 0.f) dist_shading = 0.f;
-
-        pts[i].u = shading * dist_shading;
+        pts[i].x = v->p.x;
+        pts[i].y = v->p.y;
+        // note: danger tiles don't fade
+        pts[i].u = is_danger ? shading : shading * get_tile_fade(v->p.z);
     }
+}
+
+static void draw_tile(Drawable* drawable, uint8_t* bitmap, const int pass) {
+    // opaque
+    if (pass == DRAW_PASS_DEFERRED) return;
+
+    const int n = drawable->face.n;
+    Point3du pts[5];
+    get_tile_points(&drawable->face, 0, pts);
 
     // 
     texfill(pts, n, _dither_ramps, bitmap);
@@ -962,67 +1204,103 @@ static void draw_tile(Drawable* drawable, uint8_t* bitmap) {
     */
 }
 
-static void draw_blinking_tile(Drawable* drawable, uint8_t* bitmap) {
-    DrawableFace* face = &drawable->face;
+static void draw_blinking_tile(Drawable* drawable, uint8_t* bitmap, const int pass) {
+    // opaque
+    if (pass == DRAW_PASS_DEFERRED) return;
 
-    const int n = face->n;
-    Point3du* pts = face->pts;
-    for (int i = 0; i < n; ++i) {
-        // project 
-        float w = 1.f / pts[i].z;
-        pts[i].x = 199.5f + 199.5f * w * pts[i].x;
-        pts[i].y = 119.5f - 199.5f * w * pts[i].y;
-        // works ok
-        float shading = face->material == GROUNDFACE_FLAG_SNOW ? 4.0f * pts[i].u + 8.f * w : 4.0f + 4.0f * pts[i].u + 4.f * w;
-        // attenuation
-        shading *= pts[i].light;
-        if (shading > 15.f) shading = 15.f;
-        if (shading < 0.f) shading = 0.f;
-        pts[i].u = shading;
-    }
+    Point3du pts[5];
+    get_tile_points(&drawable->face, 1, pts);
 
     // 
-    texfill(pts, n, _danger_dither_ramps, bitmap);    
+    texfill(pts, drawable->face.n, _danger_dither_ramps, bitmap);    
 }
 
-static void draw_face(Drawable* drawable, uint8_t* bitmap) {
+static void draw_face(Drawable* drawable, uint8_t* bitmap, const int pass) {
     DrawableFace* face = &drawable->face;
 
     const int n = face->n;
-    Point3du* pts = face->pts;
+    Point3du pts[5];
+    const float dist = drawable->key - (MAX_TILE_DIST * 0.707f - 2.f) * GROUND_CELL_SIZE;
+    // note: deferred pass reuses points projected by opaque pass
+    if (pass != DRAW_PASS_DEFERRED) {
+        for (int i = 0; i < n; ++i) {
+            // project (in place, vertices are owned by face)
+            Point3du* p = &DRAWABLE_VERTEX(face->v[i])->p;
+            const float w = 199.5f / p->z;
+            p->x = 199.5f +  w * p->x;
+            p->y = 119.5f -  w * p->y;
+        }
+    }
     for (int i = 0; i < n; ++i) {
-        // project 
-        const float w = 199.5f / pts[i].z;
-        pts[i].x = 199.5f +  w * pts[i].x;
-        pts[i].y = 119.5f -  w * pts[i].y;
+        pts[i] = DRAWABLE_VERTEX(face->v[i])->p;
     }
 
-    // 
-    const float dist = drawable->key - (MAX_TILE_DIST * 0.707f - 2.f) * GROUND_CELL_SIZE;
-    if (!(face->flags & FACE_FLAG_TRANSPARENT)) {
-        float shading = dist / (2.f * GROUND_CELL_SIZE);
-        if (shading > 1.f) shading = 1.f;
-        if (shading < 0.f) shading = 0.f;
-        polyfill(pts, n, _ordered_dithers + (int)(face->material * (1.f - shading)) * 32, (uint32_t*)bitmap);
+    if (pass != DRAW_PASS_DEFERRED) {
+        // 
+        if (!(face->flags & FACE_FLAG_TRANSPARENT)) {
+            float shading = dist / (2.f * GROUND_CELL_SIZE);
+            if (shading > 1.f) shading = 1.f;
+            if (shading < 0.f) shading = 0.f;
+            polyfill(pts, n, _ordered_dithers + (int)(face->material * (1.f - shading)) * 32, (uint32_t*)bitmap);
+        }
     }
 
     // don't "pop" edges if too far away
-    if ((face->flags & FACE_FLAG_EDGES) && dist < 0.f) {
+    if (pass != DRAW_PASS_OPAQUE && (face->flags & FACE_FLAG_EDGES) && dist < 0.f) {
         Point3du* p0 = &pts[n - 1];
         for (int i = 0; i < n; ++i) {
             Point3du* p1 = &pts[i];
             if (p0->u) {
-                pd->graphics->drawLine((int)p0->x, (int)p0->y, (int)p1->x, (int)p1->y, 1, kColorBlack);
+                if (pass == DRAW_PASS_DEFERRED) {
+                    sbuffer_line((int)p0->x, (int)p0->y, (int)p1->x, (int)p1->y, bitmap);
+                }
+                else {
+                    if (_capture_active) capture_line(CAPTURE_LINE, (int)p0->x, (int)p0->y, (int)p1->x, (int)p1->y);
+                    pd->graphics->drawLine((int)p0->x, (int)p0->y, (int)p1->x, (int)p1->y, 1, kColorBlack);
+                }
             }
             p0 = p1;
         }
     }
 }
 
+// copy points to (owned) arena vertices
+// returns 0 if arena is exhausted
+static int push_face_points(uint16_t* handles, const Point3du* pts, const int n) {
+    DrawableVertex* v = pop_drawable_vertices(n);
+    if (!v) return 0;
+    for (int i = 0; i < n; i++) {
+        v[i].p = pts[i];
+        handles[i] = ARENA_HANDLE(&v[i]);
+    }
+    return 1;
+}
+
+// project a camera space tile point
+static void set_tile_vertex(DrawableVertex* v, const Point3du* p) {
+    const float w = 1.f / p->z;
+    v->p = (Point3du){ .x = 199.5f + 199.5f * w * p->x, .y = 119.5f - 199.5f * w * p->y, .z = p->z, .u = p->u, .light = p->light };
+    v->w = w;
+    PROFILE_COUNT(PROFILE_COUNTER_PROJECTED, 1);
+}
+
+// project camera space points into (owned) arena vertices
+// returns 0 if arena is exhausted
+static int push_tile_points(uint16_t* handles, const Point3du* pts, const int n) {
+    DrawableVertex* v = pop_drawable_vertices(n);
+    if (!v) return 0;
+    for (int i = 0; i < n; i++) {
+        set_tile_vertex(&v[i], &pts[i]);
+        handles[i] = ARENA_HANDLE(&v[i]);
+    }
+    return 1;
+}
 
 // push a face to the drawing list
-static void push_tile(const GroundFace* f, const Mat4 m, GroundSliceCoord* coords, int n, const float light, const int is_danger) {
-    Point3du tmp[4];
+// layer: ground row layer for implicit ordering, -1 for depth sorting
+// note: tile points are projected here (once per grid vertex, except for clipped tiles), shaded by draw callbacks
+static void push_tile(const GroundContext* ctx, const GroundFace* f, const Mat4 m, GroundSliceCoord* coords, int n, const float light, const int is_danger, const int layer) {
+    CameraPoint* cps[4];
 
     // transform
     int outcode = 0xfffffff, is_clipped_near = 0;
@@ -1038,7 +1316,7 @@ static void push_tile(const GroundFace* f, const Mat4 m, GroundSliceCoord* coord
             // compute point  
             const float h = c.slice->heights[c.i];
             // project using active matrix
-            m_x_v(m, (Point3d) { .v = {(float)(c.i << 2), h + c.slice->y, (float)(c.j << 2)} }, (Point3d*)res);
+            m_x_v(m, (Point3d) { .v = {(float)(c.i << 2), h + get_slice_y(ctx, c.slice), (float)(c.j << 2)} }, (Point3d*)res);
             
             // TODO: check if useful vs. collect tiles
             const int code =
@@ -1048,6 +1326,7 @@ static void push_tile(const GroundFace* f, const Mat4 m, GroundSliceCoord* coord
                 (((Flint) { .f = res->z + res->x }.i >> 28) & OUTCODE_LEFT);
 
             cp->outcode = code;
+            cp->vertex = -1;
 
             // light
             res->u = (4.0f + h) / 8.f;
@@ -1059,29 +1338,56 @@ static void push_tile(const GroundFace* f, const Mat4 m, GroundSliceCoord* coord
         outcode &= cp->outcode;
         is_clipped_near |= cp->outcode;
         if (cp->p.z > min_key) min_key = cp->p.z;
-        // copy point to tmp array
-        tmp[i] = cp->p;
-        tmp[i].light *= light;
+        cps[i] = cp;
     }
 
     // visible?
-    if (outcode == 0) {
-        Drawable* drawable = pop_drawable(min_key);
-        drawable->draw = is_danger ?draw_blinking_tile: draw_tile;
-        drawable->key = min_key;
-        DrawableFace* face = &drawable->face;
-        face->material = f->flags & GROUNDFACE_FLAG_MATERIAL_MASK;
-        if (is_clipped_near & OUTCODE_NEAR) {
-            face->n = z_poly_clip(Z_NEAR, 1.0f, tmp, n, face->pts);
-        }
-        else if (is_clipped_near & OUTCODE_FAR) {
-            face->n = z_poly_clip(Z_FAR, -1.f, tmp, n, face->pts);
+    if (outcode != 0) {
+        PROFILE_COUNT(PROFILE_COUNTER_CULLED, 1);
+        return;
+    }
+
+    // note: face is dropped if arena is exhausted
+    uint16_t handles[5];
+    int nv = n;
+    float face_light = light;
+    if (is_clipped_near & (OUTCODE_NEAR | OUTCODE_FAR)) {
+        // clip in camera space
+        Point3du tmp[4], clipped[5];
+        for (int i = 0; i < n; ++i) {
+            tmp[i] = cps[i]->p;
+            tmp[i].light *= light;
         }
-        else {
-            face->n = n;
-            memcpy(face->pts, tmp, n * sizeof(Point3du));
+        nv = z_poly_clip(is_clipped_near & OUTCODE_NEAR ? Z_NEAR : Z_FAR, is_clipped_near & OUTCODE_NEAR ? 1.0f : -1.f, tmp, n, clipped);
+        if (!push_tile_points(handles, clipped, nv)) return;
+        // note: light already applied
+        face_light = 1.f;
+        PROFILE_COUNT(PROFILE_COUNTER_CLIPPED, 1);
+    }
+    else {
+        for (int i = 0; i < n; ++i) {
+            CameraPoint* cp = cps[i];
+            // first use?
+            if (cp->vertex < 0) {
+                DrawableVertex* v = pop_drawable_vertices(1);
+                if (!v) return;
+                set_tile_vertex(v, &cp->p);
+                cp->vertex = ARENA_HANDLE(v);
+            }
+            handles[i] = (uint16_t)cp->vertex;
         }
     }
+
+    Drawable* drawable = layer < 0 ? pop_drawable(min_key, 0) : pop_ordered_drawable(layer);
+    if (!drawable) return;
+    drawable->draw = is_danger ?draw_blinking_tile: draw_tile;
+    drawable->key = min_key;
+    DrawableFace* face = &drawable->face;
+    face->material = f->flags & GROUNDFACE_FLAG_MATERIAL_MASK;
+    face->light = face_light;
+    face->n = nv;
+    memcpy(face->v, handles, nv * sizeof(uint16_t));
+    PROFILE_COUNT(PROFILE_COUNTER_TILE_VERTICES, nv);
 }
 
 void add_render_prop(const int id, const Mat4 m) {
@@ -1094,7 +1400,7 @@ void add_render_prop(const int id, const Mat4 m) {
     memcpy(p->m, m, MAT4x4 * sizeof(float));
 }
 
-static void push_threeD_model(const int prop_id, const Point3d cv, const Mat4 m) {
+static void push_threeD_model(const int prop_id, const Point3d cv, const Mat4 m, const int layer) {
     Point3du tmp[4];
     ThreeDModel* model = _props_properties[prop_id - 1].model;
     for (int j = 0; j < model->face_count; ++j) {
@@ -1128,20 +1434,33 @@ static void push_threeD_model(const int prop_id, const Point3d cv, const Mat4 m)
             // visible?
             if (outcode == 0) {
                 const float sortkey = f->flags & FACE_FLAG_LARGE ? max_key : min_key;
-                Drawable* drawable = pop_drawable(sortkey);
+                // note: face is dropped if arena is exhausted
+                uint16_t handles[5];
+                int nv = n;
+                if (is_clipped_near & OUTCODE_NEAR) {
+                    Point3du clipped[5];
+                    nv = z_poly_clip(Z_NEAR, 1.0f, tmp, n, clipped);
+                    if (!push_face_points(handles, clipped, nv)) continue;
+                    PROFILE_COUNT(PROFILE_COUNTER_CLIPPED, 1);
+                }
+                else if (!push_face_points(handles, tmp, n)) continue;
+
+                Drawable* drawable = pop_drawable(sortkey, layer);
+                if (!drawable) continue;
                 drawable->draw = draw_face;
                 drawable->key = sortkey;
                 DrawableFace* face = &drawable->face;
                 face->flags = f->flags;
                 face->material = f->material;
-                if (is_clipped_near & OUTCODE_NEAR) {
-                    face->n = z_poly_clip(Z_NEAR, 1.0f, tmp, n, face->pts);
-                }
-                else {
-                    face->n = n;
-                    memcpy(face->pts, tmp, n * sizeof(Point3du));
-                }
-            }       
+                face->n = nv;
+                memcpy(face->v, handles, nv * sizeof(uint16_t));
+            }
+            else {
+                PROFILE_COUNT(PROFILE_COUNTER_CULLED, 1);
+            }
+        }
+        else {
+            PROFILE_COUNT(PROFILE_COUNTER_CULLED, 1);
         }
     }
 }
@@ -1162,7 +1481,7 @@ static void push_and_transform_threeD_model(const int prop_id, const Point3d cam
         m_x_y_rot(tmp, rot_scale * pd->system->getElapsedTime() + m[12], mvv);
         m_inv_x_v(mvv, cam_pos, &inv_cam_pos);
         m_x_m(cam_m, mvv, tmp);
-        push_threeD_model(prop_id, inv_cam_pos, tmp);
+        push_threeD_model(prop_id, inv_cam_pos, tmp, get_drawable_layer(m[14]));
     }
     else {
         m_x_m(cam_m, m, mvv);
@@ -1170,7 +1489,7 @@ static void push_and_transform_threeD_model(const int prop_id, const Point3d cam
         // cam pos in 3d model space
         m_inv_x_v(m, cam_pos, &inv_cam_pos);
 
-        push_threeD_model(prop_id, inv_cam_pos, mvv);
+        push_threeD_model(prop_id, inv_cam_pos, mvv, get_drawable_layer(m[14]));
     }
 }
 
@@ -1221,177 +1540,331 @@ int render_sky(const Mat4 m, uint8_t* screen) {
     return angle;
 }
 
-static void collect_tiles(uint32_t visible_tiles[GROUND_HEIGHT], const Point3d pos, float base_angle) {
-    float x = pos.x / GROUND_CELL_SIZE, y = pos.z / GROUND_CELL_SIZE;
-    int x0 = (int)x, y0 = (int)y;
-
-    // current tile is always in
-    visible_tiles[y0] |= 1 << x0;
-
-    for (int i = 0; i < RAYCAST_PRECISION; ++i) {
-        float angle = base_angle + _rays[i].angle;
-        float v = cosf(angle), u = sinf(angle);
-
-        int mapx = x0, mapy = y0;
-        int mapdx = 1, mapdy = 1;
-        // convert to fixed 24:8
-        int ddx = (int)((1 << 8) / u), ddy = (int)((1 << 8) / v);
-        int distx = 0, disty = 0;
-        if (u < 0.f) {
-            mapdx = -1;
-            ddx = -ddx;
-            distx = (x - mapx) * ddx;
-        }
-        else {
-            distx = (mapx + 1 - x) * ddx;
-        }
-        if (v < 0) {
-            mapdy = -1;
-            ddy = -ddy;
-            disty = (y - mapy) * ddy;
+// world position of the prop on tile i,j
+static Point3d get_prop_pos(const GroundContext* ctx, const int i, const int j) {
+    const GroundSlice* s0 = get_slice(ctx, j);
+    const GroundSlice* s1 = get_slice(ctx, j + 1);
+    const float t = s0->tiles[i].prop_t;
+    const float h0 = s0->heights[i] + get_slice_y(ctx, s0);
+    return (Point3d) {
+        .x = (float)(i * GROUND_CELL_SIZE) + GROUND_CELL_SIZE * t,
+        .y = h0 + (s1->heights[i + 1] + get_slice_y(ctx, s1) - s0->heights[i] - get_slice_y(ctx, s0)) * t,
+        .z = (float)(j * GROUND_CELL_SIZE) + GROUND_CELL_SIZE * t
+    };
+}
+
+// push a single ground tile (+ prop)
+// draw_faces/draw_prop: tile faces and/or prop visibility
+static void push_ground_tile(const GroundContext* ctx, const int i, const int j, const int draw_faces, const int draw_prop, const float shading_band, const int layer, const Point3d cam_pos, const Mat4 m, uint32_t blink, CameraPoint* cache[2]) {
+    const float tilex = (float)(i * GROUND_CELL_SIZE), tilez = (float)(j * GROUND_CELL_SIZE);
+    GroundSlice* s0 = get_slice(ctx, j);
+    GroundTile* t0 = &s0->tiles[i];
+    GroundSlice* s1 = get_slice(ctx, j + 1);
+    const float h0 = s0->heights[i] + get_slice_y(ctx, s0);
+    // camera to face point
+    const Point3d cv = { .x = tilex - cam_pos.x, .y = h0 - cam_pos.y, .z = tilez - cam_pos.z };
+    const GroundFace* f0 = &t0->f0;
+    const int is_danger = blink & (1 << i);
+    if (draw_faces) {
+        PROFILE_COUNT(PROFILE_COUNTER_TILES, 1);
+        if (f0->flags & GROUNDFACE_FLAG_QUAD) {
+            if (v_dot(f0->n, cv) < 0.f)
+            {
+                push_tile(ctx, f0, m, (GroundSliceCoord[]) {
+                    { .slice = s0, .i = i,     .j = j,     .cache = cache[0], .mask = s1->tracks_mask },
+                    { .slice = s0, .i = i + 1, .j = j,     .cache = cache[0], .mask = s1->tracks_mask },
+                    { .slice = s1, .i = i + 1, .j = j + 1, .cache = cache[1], .mask = s0->tracks_mask },
+                    { .slice = s1, .i = i,     .j = j + 1, .cache = cache[1], .mask = s0->tracks_mask }
+                }, 4, shading_band, is_danger, layer);
+            }
+            else {
+                PROFILE_COUNT(PROFILE_COUNTER_CULLED, 1);
+            }
         }
         else {
-            disty = (mapy + 1 - y) * ddy;
+            const GroundFace* f1 = &t0->f1;
+            // implicit ordering: farthest triangle first (camera above diagonal = f0 side)
+            const int f1_first = layer >= 0 && (cam_pos.z - tilez > cam_pos.x - tilex);
+            for (int k = 0; k < 2; k++) {
+                if (k == f1_first) {
+                    if (v_dot(f0->n, cv) < 0.f)
+                    {
+                        push_tile(ctx, f0, m, (GroundSliceCoord[]) {
+                            { .slice = s0, .i = i,      .j = j,     .cache = cache[0], .mask = s1->tracks_mask },
+                            { .slice = s1, .i = i + 1,  .j = j + 1, .cache = cache[1], .mask = s0->tracks_mask },
+                            { .slice = s1, .i = i,      .j = j + 1, .cache = cache[1], .mask = s0->tracks_mask }
+                        }, 3, shading_band, is_danger, layer);
+                    }
+                    else {
+                        PROFILE_COUNT(PROFILE_COUNTER_CULLED, 1);
+                    }
+                }
+                else {
+                    if (v_dot(f1->n, cv) < 0.f)
+                    {
+                        push_tile(ctx, f1, m, (GroundSliceCoord[]) {
+                            { .slice = s0, .i = i,     .j = j,     .cache = cache[0], .mask = s1->tracks_mask},
+                            { .slice = s0, .i = i + 1, .j = j,     .cache = cache[0], .mask = s1->tracks_mask },
+                            { .slice = s1, .i = i + 1, .j = j + 1, .cache = cache[1], .mask = s0->tracks_mask }
+                        }, 3, shading_band, is_danger, layer);
+                    }
+                    else {
+                        PROFILE_COUNT(PROFILE_COUNTER_CULLED, 1);
+                    }
+                }
+            }
         }
-
-        const int dist_max = _rays[i].distance;
-        while((distx * distx) + (disty * disty) < dist_max) {
-            if (distx < disty) {
-                distx += ddx;
-                mapx += mapdx;
+    }
+    // draw prop (if any)
+    int prop_id = t0->prop_id;
+    if (draw_prop && prop_id) {
+        const Point3d pos = get_prop_pos(ctx, i, j);
+        Point3d res;
+        m_x_v(m, pos, &res);
+        if (res.z > Z_NEAR && res.z < (float)(GROUND_CELL_SIZE * MAX_TILE_DIST)) {
+            PROFILE_COUNT(PROFILE_COUNTER_PROPS, 1);
+            Point3d cv;
+            Mat4 mmvm;
+            // adjust matrix to project into position
+            const int flags = _props_properties[prop_id - 1].flags;
+            if (flags & PROP_FLAG_Y_ROTATE) {
+                Mat4 tmp = {
+                    1.f,0.f,0.f,0.f,
+                    0.f,1.f,0.f,0.f,
+                    0.f,0.f,1.f,0.f,
+                    pos.x,pos.y,pos.z,1.f };
+                const float rot_scale = flags & PROP_FLAG_ROTATE_SLOW ? 1.0f : 2.0f;
+                m_x_y_rot(tmp, rot_scale * pd->system->getElapsedTime() + pos.x, mmvm);
+                m_inv_x_v(mmvm, cam_pos, &cv);
+                m_x_m(m, mmvm, tmp);
+                push_threeD_model(prop_id, cv, tmp, get_drawable_layer(pos.z));
             }
             else {
-                disty += ddy;
-                mapy += mapdy;
+                cv = (Point3d){.x = cam_pos.x - pos.x, .y = cam_pos.y - pos.y, .z = cam_pos.z - pos.z};
+                m_x_translate(m, pos, mmvm);
+                push_threeD_model(prop_id, cv, mmvm, get_drawable_layer(pos.z));
             }
-            // out of range?
-            if (mapx&~(GROUND_WIDTH-1) || mapy<0 || mapy >= GROUND_HEIGHT) break;
+        }
+    }
+}
 
-            visible_tiles[mapy] |= 1 << mapx;
+// push visible tiles of row j
+// visible_props: tiles with a visible prop (if any)
+// ci: camera column for implicit ordering (columns converging to camera), -1 for depth sorting
+static void push_ground_row(const GroundContext* ctx, const int j, const uint32_t visible_tiles, const uint32_t visible_props, const int ci, const Point3d cam_pos, const Mat4 m, uint32_t blink, CameraPoint* cache[2]) {
+    // slightly alter shading of even/odd slices
+    const float shading_band = SHADING_CONTRAST * (0.5f + 0.5f * ((j + ctx->z_offset) & 1));
+    const uint32_t mask = visible_tiles | visible_props;
+    if (ci < 0) {
+        for (int i = 0; i < GROUND_WIDTH; i++) {
+            // is the tile bit enabled?
+            if (mask & (1 << i)) {
+                push_ground_tile(ctx, i, j, visible_tiles & (1 << i), visible_props & (1 << i), shading_band, -1, cam_pos, m, blink, cache);
+            }
+        }
+        return;
+    }
+
+    const int layer = get_drawable_layer((float)(j * GROUND_CELL_SIZE));
+    for (int i = 0; i < ci; i++) {
+        if (mask & (1 << i)) {
+            push_ground_tile(ctx, i, j, visible_tiles & (1 << i), visible_props & (1 << i), shading_band, layer, cam_pos, m, blink, cache);
+        }
+    }
+    for (int i = GROUND_WIDTH - 1; i >= ci; i--) {
+        if (mask & (1 << i)) {
+            push_ground_tile(ctx, i, j, visible_tiles & (1 << i), visible_props & (1 << i), shading_band, layer, cam_pos, m, blink, cache);
         }
     }
 }
 
-// render ground
+// project vertices of slice j used by tiles in mask (other vertices are marked as not projected)
+static void project_slice(const GroundContext* ctx, const int j, const uint32_t mask, const Mat4 m, Point3d* out) {
+    const GroundSlice* s = get_slice(ctx, j);
+    const uint32_t vertices = mask | (mask << 1);
+    for (int i = 0; i < GROUND_WIDTH; i++) {
+        Point3d* res = &out[i];
+        if (!(vertices & (1 << i))) {
+            res->z = -1.f;
+            continue;
+        }
+        m_x_v(m, (Point3d) { .v = { (float)(i * GROUND_CELL_SIZE), s->heights[i] + get_slice_y(ctx, s), (float)(j * GROUND_CELL_SIZE) } }, res);
+        if (res->z >= Z_NEAR) {
+            const float w = 199.5f / res->z;
+            res->x = 199.5f + w * res->x;
+            res->y = 119.5f - w * res->y;
+        }
+    }
+}
 
-void render_ground(const Point3d cam_pos, const float cam_tau_angle, const Mat4 cam_m, uint32_t blink, uint8_t * bitmap) {
-    // cache lines
-    CameraPoint c0[GROUND_WIDTH];
-    CameraPoint c1[GROUND_WIDTH];
-    CameraPoint* cache[2] = { c0, c1 };
-    // reset cache
-    for (int i = 0; i < GROUND_WIDTH; ++i) {
-        c0[i].outcode = -1;
+// is prop (bounds) on tile i,j hidden by horizon?
+static int is_prop_hidden(const GroundContext* ctx, const int i, const int j, const Mat4 m) {
+    const PropProperties* props = &_props_properties[get_slice(ctx, j)->tiles[i].prop_id - 1];
+    // must not overlap previous slice (horizon is built from slices in front of it)
+    const float r = props->bounds_radius;
+    if (r >= GROUND_CELL_SIZE) return 0;
+
+    const Point3d pos = get_prop_pos(ctx, i, j);
+    float x0 = FLT_MAX, x1 = -FLT_MAX, y0 = FLT_MAX;
+    for (int k = 0; k < 8; k++) {
+        const Point3d corner = { .v = {
+            pos.x + (k & 1 ? r : -r),
+            pos.y + (k & 2 ? props->bounds_y.max : props->bounds_y.min),
+            pos.z + (k & 4 ? r : -r) } };
+        Point3d res;
+        m_x_v(m, corner, &res);
+        if (res.z < Z_NEAR) return 0;
+        const float w = 199.5f / res.z;
+        const float x = 199.5f + w * res.x, y = 119.5f - w * res.y;
+        if (x < x0) x0 = x;
+        if (x > x1) x1 = x;
+        if (y < y0) y0 = y;
     }
+    return horizon_is_hidden(x0, x1, y0);
+}
+
+// horizon occlusion: clears tiles & props hidden by nearer terrain
+// processes rows in front of the camera row (cj), near to far
+static void cull_hidden_tiles(const GroundContext* ctx, const int cj, const Mat4 m, uint32_t tiles[GROUND_HEIGHT], uint32_t props[GROUND_HEIGHT]) {
+    Point3d line0[GROUND_WIDTH], line1[GROUND_WIDTH];
+    Point3d* lines[2] = { line0, line1 };
+
+    horizon_clear();
+    project_slice(ctx, cj + 1, tiles[cj + 1], m, lines[0]);
+    for (int j = cj + 1; j < GROUND_HEIGHT - 1; j++) {
+        const uint32_t next_tiles = j + 1 < GROUND_HEIGHT - 1 ? tiles[j + 1] : 0;
+        project_slice(ctx, j + 1, tiles[j] | next_tiles, m, lines[1]);
+
+        // props: against horizon up to previous slice (props may overlap near edge)
+        const GroundSlice* s = get_slice(ctx, j);
+        for (int i = 0; i < GROUND_WIDTH - 1; i++) {
+            if ((props[j] & (1 << i)) && s->tiles[i].prop_id && is_prop_hidden(ctx, i, j, m)) {
+                props[j] &= ~(1 << i);
+                PROFILE_COUNT(PROFILE_COUNTER_HIDDEN_PROPS, 1);
+            }
+        }
+
+        // tiles: against horizon including near edge
+        horizon_push_line(lines[0], GROUND_WIDTH);
+        for (int i = 0; i < GROUND_WIDTH - 1; i++) {
+            if (!(tiles[j] & (1 << i))) continue;
+            const Point3d* quad[4] = { &lines[0][i], &lines[0][i + 1], &lines[1][i], &lines[1][i + 1] };
+            float x0 = FLT_MAX, x1 = -FLT_MAX, y0 = FLT_MAX;
+            int k = 0;
+            for (; k < 4; k++) {
+                const Point3d* p = quad[k];
+                if (p->z < Z_NEAR) break;
+                if (p->x < x0) x0 = p->x;
+                if (p->x > x1) x1 = p->x;
+                if (p->y < y0) y0 = p->y;
+            }
+            if (k == 4 && horizon_is_hidden(x0, x1, y0)) {
+                tiles[j] &= ~(1 << i);
+                PROFILE_COUNT(PROFILE_COUNTER_HIDDEN_TILES, 1);
+            }
+        }
+
+        Point3d* tmp = lines[0];
+        lines[0] = lines[1];
+        lines[1] = tmp;
+    }
+}
+
+// push visible ground rows (cache: 2 camera space lines)
+static void push_ground_rows(const GroundContext* ctx, const uint32_t tiles[GROUND_HEIGHT], const uint32_t props[GROUND_HEIGHT], const int ci, const int cj, const Point3d cam_pos, const Mat4 m, uint32_t blink, CameraPoint* cache[2]) {
     for (int i = 0; i < GROUND_WIDTH; ++i) {
-        c1[i].outcode = -1;
+        cache[0][i].outcode = -1;
+        cache[1][i].outcode = -1;
     }
+    if (_render_flags & RENDER_FLAG_ORDERED_GROUND) {
+        // painter's order: far rows first, columns converging toward camera
+        set_drawables_layers(cj);
+
+        // rows in front of camera, far to near (keeps "far" cache line)
+        for (int j = GROUND_HEIGHT - 2; j > cj; j--) {
+            push_ground_row(ctx, j, tiles[j], props[j], ci, cam_pos, m, blink, cache);
+            CameraPoint* tmp = cache[1];
+            cache[1] = cache[0];
+            cache[0] = tmp;
+            for (int i = 0; i < GROUND_WIDTH; ++i) {
+                tmp[i].outcode = -1;
+            }
+        }
+        // rows behind & camera row, far to near (keeps "near" cache line)
+        for (int i = 0; i < GROUND_WIDTH; ++i) {
+            cache[0][i].outcode = -1;
+            cache[1][i].outcode = -1;
+        }
+        for (int j = 0; j <= cj; j++) {
+            push_ground_row(ctx, j, tiles[j], props[j], ci, cam_pos, m, blink, cache);
+            CameraPoint* tmp = cache[0];
+            cache[0] = cache[1];
+            cache[1] = tmp;
+            for (int i = 0; i < GROUND_WIDTH; ++i) {
+                tmp[i].outcode = -1;
+            }
+        }
+    }
+    else {
+        for (int j = 0; j < GROUND_HEIGHT - 1; j++) {
+            push_ground_row(ctx, j, tiles[j], props[j], -1, cam_pos, m, blink, cache);
+            // swap cache lines
+            CameraPoint* tmp = cache[0];
+            cache[0] = cache[1];
+            cache[1] = tmp;
+            for (int i = 0; i < GROUND_WIDTH; ++i) {
+                tmp[i].outcode = -1;
+            }
+        }
+    }
+}
 
+// render ground
+
+void render_ground(const GroundContext* ctx, const Point3d cam_pos, const float cam_tau_angle, const Mat4 cam_m, uint32_t blink, uint8_t * bitmap) {
     // store cam matrix on stack
     Mat4 m;
     memcpy(m, cam_m, MAT4x4 * sizeof(float));
     const float cam_angle = cam_tau_angle * 2.f * PI;
+    PROFILE_BEGIN_FRAME();
+    PROFILE_ZONE_BEGIN(PROFILE_STAGE_SKY);
     render_sky(m, bitmap);
+    PROFILE_ZONE_END(PROFILE_STAGE_SKY);
 
     // collect visible tiles
     // visible tiles encoded as 1 bit per cell
+    PROFILE_ZONE_BEGIN(PROFILE_STAGE_COLLECT);
     uint32_t tiles[GROUND_HEIGHT] = { 0 };
-    collect_tiles(tiles, cam_pos, cam_angle);
+    if (_render_flags & RENDER_FLAG_RAYCAST_TILES) {
+        collect_tiles_raycast(tiles, cam_pos, cam_angle);
+    }
+    else {
+        collect_tiles_wedge(tiles, cam_pos, cam_angle);
+    }
+    // camera tile
+    int ci = (int)(cam_pos.x / GROUND_CELL_SIZE), cj = (int)(cam_pos.z / GROUND_CELL_SIZE);
+    if (ci < 0) ci = 0;
+    if (ci > GROUND_WIDTH - 1) ci = GROUND_WIDTH - 1;
+    if (cj < 0) cj = 0;
+    if (cj > GROUND_HEIGHT - 2) cj = GROUND_HEIGHT - 2;
+    // tiles with a visible prop
+    uint32_t props[GROUND_HEIGHT];
+    memcpy(props, tiles, sizeof(props));
+    if (_render_flags & RENDER_FLAG_HORIZON_CULL) {
+        cull_hidden_tiles(ctx, cj, m, tiles, props);
+    }
+    PROFILE_ZONE_END(PROFILE_STAGE_COLLECT);
 
     // transform
+    PROFILE_ZONE_BEGIN(PROFILE_STAGE_TRANSFORM);
     reset_drawables();
-    float tilez = 0.f;
-    for (int j = 0; j < GROUND_HEIGHT - 1; j++, tilez += GROUND_CELL_SIZE) {
-        // const uint32_t visible_tiles = tiles[j];
-        const uint32_t visible_tiles = tiles[j];
-        // slightly alter shading of even/odd slices
-        const float shading_band = SHADING_CONTRAST * (0.5f + 0.5f * ((j + _z_offset) & 1));
-        float tilex = 0.f;
-        for (int i = 0; i < GROUND_WIDTH; i++, tilex+=GROUND_CELL_SIZE) {
-            // is the tile bit enabled?
-            if (visible_tiles & (1 << i)) {
-                GroundSlice* s0 = _ground.slices[j];
-                GroundTile* t0 = &s0->tiles[i];
-                GroundSlice* s1 = _ground.slices[j + 1];
-                const float h0 = s0->heights[i] + s0->y;
-                // camera to face point
-                const Point3d cv = { .x = tilex - cam_pos.x, .y = h0 - cam_pos.y, .z = tilez - cam_pos.z };
-                const GroundFace* f0 = &t0->f0;
-                const int is_danger = blink & (1 << i);
-                if (f0->flags & GROUNDFACE_FLAG_QUAD) {
-                    if (v_dot(f0->n, cv) < 0.f)
-                    {
-                        push_tile(f0, m, (GroundSliceCoord[]) {
-                            { .slice = s0, .i = i,     .j = j,     .cache = cache[0], .mask = s1->tracks_mask },
-                            { .slice = s0, .i = i + 1, .j = j,     .cache = cache[0], .mask = s1->tracks_mask },
-                            { .slice = s1, .i = i + 1, .j = j + 1, .cache = cache[1], .mask = s0->tracks_mask },
-                            { .slice = s1, .i = i,     .j = j + 1, .cache = cache[1], .mask = s0->tracks_mask }
-                        }, 4, shading_band, is_danger);
-                    }
-                }
-                else {
-                    if (v_dot(f0->n, cv) < 0.f)
-                    {
-                        push_tile(f0, m, (GroundSliceCoord[]) {
-                            { .slice = s0, .i = i,      .j = j,     .cache = cache[0], .mask = s1->tracks_mask },
-                            { .slice = s1, .i = i + 1,  .j = j + 1, .cache = cache[1], .mask = s0->tracks_mask },
-                            { .slice = s1, .i = i,      .j = j + 1, .cache = cache[1], .mask = s0->tracks_mask }
-                        }, 3, shading_band, is_danger);
-                    }
-                    const GroundFace* f1 = &t0->f1;
-                    if (v_dot(f1->n, cv) < 0.f)
-                    {
-                        push_tile(f1, m, (GroundSliceCoord[]) {
-                            { .slice = s0, .i = i,     .j = j,     .cache = cache[0], .mask = s1->tracks_mask},
-                            { .slice = s0, .i = i + 1, .j = j,     .cache = cache[0], .mask = s1->tracks_mask },
-                            { .slice = s1, .i = i + 1, .j = j + 1, .cache = cache[1], .mask = s0->tracks_mask }
-                        }, 3, shading_band, is_danger);
-                    }
-                }
-                // draw prop (if any)
-                int prop_id = t0->prop_id;
-                if (prop_id) {
-                    const float t = t0->prop_t;
-                    const Point3d pos = {
-                        .x = tilex + GROUND_CELL_SIZE * t,
-                        .y = h0 + (s1->heights[i + 1] + s1->y - s0->heights[i] - s0->y) * t,
-                        .z = tilez + GROUND_CELL_SIZE * t
-                    };
-                    Point3d res;
-                    m_x_v(m, pos, &res);
-                    if (res.z > Z_NEAR && res.z < (float)(GROUND_CELL_SIZE * MAX_TILE_DIST)) {
-                        Point3d cv;
-                        Mat4 mmvm;
-                        // adjust matrix to project into position
-                        const int flags = _props_properties[prop_id - 1].flags;
-                        if (flags & PROP_FLAG_Y_ROTATE) {
-                            Mat4 tmp = {
-                                1.f,0.f,0.f,0.f,
-                                0.f,1.f,0.f,0.f,
-                                0.f,0.f,1.f,0.f,
-                                pos.x,pos.y,pos.z,1.f };
-                            const float rot_scale = flags & PROP_FLAG_ROTATE_SLOW ? 1.0f : 2.0f;
-                            m_x_y_rot(tmp, rot_scale * pd->system->getElapsedTime() + pos.x, mmvm);
-                            m_inv_x_v(mmvm, cam_pos, &cv);
-                            m_x_m(m, mmvm, tmp);
-                            push_threeD_model(prop_id, cv, tmp);
-                        }
-                        else {
-                            cv = (Point3d){.x = cam_pos.x - pos.x, .y = cam_pos.y - pos.y, .z = cam_pos.z - pos.z};
-                            m_x_translate(m, pos, mmvm);
-                            push_threeD_model(prop_id, cv, mmvm);
-                        }
-                    }
-                }
-            }
-        }
-        // swap cache lines
-        CameraPoint* tmp = cache[0];
-        cache[0] = cache[1];
-        cache[1] = tmp;
-        for (int i = 0; i < GROUND_WIDTH; ++i) {
-            tmp[i].outcode = -1;
-        }
+    // cache lines (frame arena)
+    CameraPoint* cache[2] = {
+        arena_alloc(GROUND_WIDTH * sizeof(CameraPoint)),
+        arena_alloc(GROUND_WIDTH * sizeof(CameraPoint)) };
+    // note: no ground if arena is too small
+    if (cache[0] && cache[1]) {
+        push_ground_rows(ctx, tiles, props, ci, cj, cam_pos, m, blink, cache);
     }
 
     // any "free" props?
@@ -1401,12 +1874,16 @@ void render_ground(const Point3d cam_pos, const float cam_tau_angle, const Mat4
     }
     // reset "free" props
     _render_props.n = 0;
+    PROFILE_ZONE_END(PROFILE_STAGE_TRANSFORM);
 
     // particles?
+    PROFILE_ZONE_BEGIN(PROFILE_STAGE_PARTICLES);
     push_particles(cam_pos, m);
+    PROFILE_ZONE_END(PROFILE_STAGE_PARTICLES);
 
     // sort & renders back to front
-    draw_drawables(bitmap);
+    draw_drawables(bitmap, _render_flags & RENDER_FLAG_SBUFFER);
+    PROFILE_END_FRAME();
 
     /*
     uint32_t* dst = (uint32_t*)bitmap;
@@ -1429,6 +1906,14 @@ void render_ground(const Point3d cam_pos, const float cam_tau_angle, const Mat4
     */
 }
 
+void set_render_flags(const int flags) {
+    _render_flags = flags;
+}
+
+int get_render_flags() {
+    return _render_flags;
+}
+
 // render "free" props without ground (for title screen say)
 void render_props(const Point3d cam_pos, const Mat4 m, uint8_t* bitmap) {
     // "free" props?
@@ -1444,5 +1929,5 @@ void render_props(const Point3d cam_pos, const Mat4 m, uint8_t* bitmap) {
     push_particles(cam_pos, m);
 
     // sort & renders back to front
-    draw_drawables(bitmap);
+    draw_drawables(bitmap, _render_flags & RENDER_FLAG_SBUFFER);
 }
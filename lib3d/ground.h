@@ -31,31 +31,72 @@ typedef struct {
 	TrackPattern pattern[GROUND_HEIGHT];
 } TrackPatterns;
 
+// ground instance (slices + course generator)
+// note: contexts are independent (e.g. can be generated in parallel), rendering is not reentrant
+typedef struct GroundContext GroundContext;
+
+GroundContext* create_ground_context();
+void destroy_ground_context(GroundContext* ctx);
+
 // create a new ground
-void make_ground(GroundParams params, TrackPatterns* patterns);
+void make_ground(GroundContext* ctx, GroundParams params, TrackPatterns* patterns);
+
+// active ground parameters
+const GroundParams* get_ground_params(const GroundContext* ctx);
+
+// ground snapshot (versioned POD blob)
+#define GROUND_STATE_VERSION 2
+typedef struct GroundState GroundState;
+
+// snapshot size in bytes
+int get_ground_state_size();
+
+// capture course generator state + visible ground
+void save_ground_state(const GroundContext* ctx, GroundState* out);
+
+// rebuild the exact same ground (visible & pre-generated slices)
+// returns 0 if snapshot is not compatible
+int restore_ground_state(GroundContext* ctx, const GroundState* state, TrackPatterns* patterns);
 
 // start position (to be called after make_ground)
-void get_start_pos(Point3d* out);
+void get_start_pos(const GroundContext* ctx, Point3d* out);
 
 // return face details at given position
 // returns 0 if out of bounds
-int get_face(const Point3d pos, Point3d* n, float* y);
+int get_face(const GroundContext* ctx, const Point3d pos, Point3d* n, float* y);
  
 // get track extent & direction
-void get_track_info(const Point3d pos, float* xmin, float* xmax, float*z, int* checkpoint, float* angle);
+void get_track_info(const GroundContext* ctx, const Point3d pos, float* xmin, float* xmax, float*z, int* checkpoint, float* angle);
 
 // clear checkpoint flag at pos
-void clear_checkpoint(const Point3d pos);
+void clear_checkpoint(GroundContext* ctx, const Point3d pos);
 
 // update ground, create new slice as necessary and adjust position
-// offset contains the ground "position" offset when slices are created
-void update_ground(const Point3d pos, int* slice_id, TrackPattern* pattern, Point3d* offset);
+// offset contains the ground "position" offset when slices are created (to be applied to particles & actors)
+void update_ground(GroundContext* ctx, const Point3d pos, int* slice_id, TrackPattern* pattern, Point3d* offset);
+
+// max. time spent generating slices ahead of view per frame (in microseconds)
+// 0: slices are generated when needed
+void set_generation_budget(const int us);
 
 // check collision
-void collide(Point3d pos, float radius, int* hit_type);
+void collide(GroundContext* ctx, Point3d pos, float radius, int* hit_type);
+
+// render options
+// ground tiles drawn in implicit painter's order (only props & particles are sorted)
+#define RENDER_FLAG_ORDERED_GROUND 1
+// front to back rasterization with a span buffer (transparent stuff drawn in a second pass)
+#define RENDER_FLAG_SBUFFER 2
+// visible tiles using ray casting (instead of view wedge scan conversion)
+#define RENDER_FLAG_RAYCAST_TILES 4
+// skip tiles & props hidden behind nearer terrain (horizon buffer)
+#define RENDER_FLAG_HORIZON_CULL 8
+
+void set_render_flags(const int flags);
+int get_render_flags();
 
 // render ground
-void render_ground(const Point3d pos, const float tau_angle, const Mat4 m, uint32_t blink, uint8_t* bitmap);
+void render_ground(const GroundContext* ctx, const Point3d pos, const float tau_angle, const Mat4 m, uint32_t blink, uint8_t* bitmap);
 
 // register a new "free" prop to be rendered using the given transformation matrix
 void add_render_prop(const int id, const Mat4 m);
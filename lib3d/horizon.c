@@ -0,0 +1,97 @@
+#include <float.h>
+#include "horizon.h"
+#include "ground_limits.h"
+
+static PlaydateAPI* pd;
+
+// rasterization margin (in pixels)
+#define HORIZON_EPSILON 1.f
+
+// lowest silhouette row per band (LCD_ROWS: nothing hidden)
+static float _horizon[HORIZON_BANDS];
+
+void horizon_clear() {
+    for (int i = 0; i < HORIZON_BANDS; i++) {
+        _horizon[i] = (float)LCD_ROWS;
+    }
+}
+
+// lowest point of a terrain run over each band fully covered by the run
+static void push_run(const Point3d* pts, const int n) {
+    if (n < 2) return;
+
+    float band_y[HORIZON_BANDS];
+    float xmin = FLT_MAX, xmax = -FLT_MAX;
+    for (int i = 0; i < HORIZON_BANDS; i++) {
+        band_y[i] = -FLT_MAX;
+    }
+    for (int k = 0; k < n; k++) {
+        if (pts[k].x < xmin) xmin = pts[k].x;
+        if (pts[k].x > xmax) xmax = pts[k].x;
+    }
+    // bands fully covered by the run (band b: [b, b + 1[ << shift)
+    int b0 = (int)ceilf(xmin) + (1 << HORIZON_BAND_SHIFT) - 1;
+    if (b0 < 0) b0 = 0;
+    b0 >>= HORIZON_BAND_SHIFT;
+    int b1 = (int)floorf(xmax) >> HORIZON_BAND_SHIFT;
+    if (b1 > HORIZON_BANDS) b1 = HORIZON_BANDS;
+    if (b0 >= b1) return;
+
+    for (int k = 1; k < n; k++) {
+        const Point3d* p0 = &pts[k - 1];
+        const Point3d* p1 = &pts[k];
+        if (p0->x > p1->x) {
+            const Point3d* tmp = p0;
+            p0 = p1;
+            p1 = tmp;
+        }
+        const float dx = p1->x - p0->x;
+        const float slope = dx > FLT_EPSILON ? (p1->y - p0->y) / dx : 0.f;
+        int s0 = (int)floorf(p0->x) >> HORIZON_BAND_SHIFT, s1 = (int)floorf(p1->x) >> HORIZON_BAND_SHIFT;
+        if (s0 < b0) s0 = b0;
+        if (s1 > b1 - 1) s1 = b1 - 1;
+        for (int b = s0; b <= s1; b++) {
+            // segment clipped to band: extremes are at the clipped ends
+            float x0 = (float)(b << HORIZON_BAND_SHIFT), x1 = (float)((b + 1) << HORIZON_BAND_SHIFT);
+            if (x0 < p0->x) x0 = p0->x;
+            if (x1 > p1->x) x1 = p1->x;
+            if (x0 > x1) continue;
+            float y = p0->y + slope * (x0 - p0->x);
+            if (y > band_y[b]) band_y[b] = y;
+            y = p0->y + slope * (x1 - p0->x);
+            if (y > band_y[b]) band_y[b] = y;
+            // vertical segment
+            if (p1->y > band_y[b] && dx <= FLT_EPSILON) band_y[b] = p1->y;
+        }
+    }
+    for (int b = b0; b < b1; b++) {
+        if (band_y[b] < _horizon[b]) _horizon[b] = band_y[b];
+    }
+}
+
+void horizon_push_line(const Point3d* pts, const int n) {
+    int start = 0;
+    for (int k = 0; k < n; k++) {
+        if (pts[k].z < Z_NEAR) {
+            push_run(pts + start, k - start);
+            start = k + 1;
+        }
+    }
+    push_run(pts + start, n - start);
+}
+
+int horizon_is_hidden(const float x0, const float x1, const float y) {
+    // offscreen: up to frustum culling
+    if (x1 < 0.f || x0 >= (float)LCD_COLUMNS) return 0;
+    int b0 = x0 < 0.f ? 0 : (int)x0 >> HORIZON_BAND_SHIFT;
+    int b1 = x1 >= (float)LCD_COLUMNS ? HORIZON_BANDS - 1 : (int)x1 >> HORIZON_BAND_SHIFT;
+    for (int b = b0; b <= b1; b++) {
+        if (y < _horizon[b] + HORIZON_EPSILON) return 0;
+    }
+    return 1;
+}
+
+void horizon_init(PlaydateAPI* playdate) {
+    pd = playdate;
+    horizon_clear();
+}
@@ -0,0 +1,29 @@
+#ifndef _horizon_h
+#define _horizon_h
+
+#include <pd_api.h>
+#include "3dmath.h"
+
+// floating horizon occlusion buffer
+// keeps the lowest screen row of the terrain silhouette per band of screen columns
+// anything entirely below the horizon is hidden by nearer terrain
+// note: only valid for terrain lines pushed near to far, with the camera above terrain
+
+// screen columns per band
+#define HORIZON_BAND_SHIFT 3
+#define HORIZON_BANDS (LCD_COLUMNS >> HORIZON_BAND_SHIFT)
+
+// reset horizon (nothing hidden)
+void horizon_clear();
+
+// add a terrain line (projected points, left to right)
+// points with z < Z_NEAR (not projected) break the line
+void horizon_push_line(const Point3d* pts, const int n);
+
+// returns true if screen span [x0, x1] is entirely below the horizon from row y (top)
+int horizon_is_hidden(const float x0, const float x1, const float y);
+
+// init module
+void horizon_init(PlaydateAPI* playdate);
+
+#endif
@@ -17,6 +17,14 @@
 #include "drawables.h"
 #include "lua3dmath.h"
 #include "rand_r.h"
+#include "bench.h"
+#include "profile.h"
+#include "visibility.h"
+#include "horizon.h"
+#include "sim.h"
+#include "record.h"
+#include "capture.h"
+#include "arena.h"
 
 #define REGISTER_LUA_FUNC(func) \
 	do {\
@@ -25,6 +33,10 @@
 	} while(0)
 
 static PlaydateAPI* pd = NULL;
+// ground used by lua api
+static GroundContext* _ground = NULL;
+// player inputs of the active run
+static InputRecorder _recorder = { 0 };
 
 void* getArgObject(int n, char* type)
 {
@@ -138,6 +150,24 @@ static const lua_reg lib3D_TrackPatterns[] =
 	{ NULL,				NULL }
 };
 
+// ************************
+// Ground state (snapshot)
+// ************************
+static GroundState* getGroundStateParam(int n) { return getArgObject(n, "lib3d.GroundState"); }
+
+static int ground_state_gc(lua_State* L)
+{
+	GroundState* p = getGroundStateParam(1);
+	lib3d_free(p);
+	return 0;
+}
+
+static const lua_reg lib3D_GroundState[] =
+{
+	{ "__gc", 			ground_state_gc },
+	{ NULL,				NULL }
+};
+
 
 // 
 static int lib3d_render_ground(lua_State* L)
@@ -156,7 +186,7 @@ static int lib3d_render_ground(lua_State* L)
 
     uint8_t* bitmap = pd->graphics->getFrame();
 
-	render_ground(*cam_pos, tau_angle, *m, blink, bitmap);
+	render_ground(_ground, *cam_pos, tau_angle, *m, blink, bitmap);
 
 	// get userdata stats
 	// int vlen, vmax, mlen, mmax;
@@ -188,7 +218,7 @@ static int lib3d_render_props(lua_State* L)
 
 static int lib3d_get_start_pos(lua_State* L) {
 	Point3d* p = pop_vec3();
-    get_start_pos(p);
+    get_start_pos(_ground, p);
 
 	pushArgVec3(p);
     return 1;
@@ -197,8 +227,42 @@ static int lib3d_get_start_pos(lua_State* L) {
 static int lib3d_make_ground(lua_State* L) {
 	GroundParams* p = getGroundParams(1);
 	
+	// reset gameplay sequence
+	rand_r_init(p->r_seed);
+
 	TrackPatterns* patterns = lib3d_malloc(sizeof(TrackPatterns));;
-	make_ground(*p,patterns);
+	make_ground(_ground, *p,patterns);
+
+	pd->lua->pushObject(patterns, "lib3d.TrackPatterns", 0);
+	return 1;
+}
+
+// snapshot of the active ground (e.g. checkpoint)
+static int lib3d_save_ground_state(lua_State* L) {
+	GroundState* state = lib3d_malloc(get_ground_state_size());
+	save_ground_state(_ground, state);
+
+	pd->lua->pushObject(state, "lib3d.GroundState", 0);
+	return 1;
+}
+
+// rebuild ground from snapshot
+// returns the track patterns (same as make_ground) or nil if snapshot is invalid
+static int lib3d_restore_ground_state(lua_State* L) {
+	GroundState* state = getGroundStateParam(1);
+	if (!state) {
+		pd->lua->pushNil();
+		return 1;
+	}
+
+	TrackPatterns* patterns = lib3d_malloc(sizeof(TrackPatterns));
+	if (!restore_ground_state(_ground, state, patterns)) {
+		lib3d_free(patterns);
+		pd->lua->pushNil();
+		return 1;
+	}
+	// restart gameplay sequence
+	rand_r_init(get_ground_params(_ground)->r_seed);
 
 	pd->lua->pushObject(patterns, "lib3d.TrackPatterns", 0);
 	return 1;
@@ -210,7 +274,7 @@ static int lib3d_get_face(lua_State* L) {
 	Point3d* n = getArgVec3(argc++);
 
 	float y;
-	if (get_face(*pos, n, &y)) {
+	if (get_face(_ground, *pos, n, &y)) {
 
 		pd->lua->pushFloat(y);
 		pushArgVec3(n);
@@ -225,7 +289,7 @@ static int lib3d_get_track_info(lua_State* L) {
 	
 	float xmin, xmax,z,angle;
 	int is_checkpoint;
-	get_track_info(*pos, &xmin, &xmax, &z, &is_checkpoint,&angle);
+	get_track_info(_ground, *pos, &xmin, &xmax, &z, &is_checkpoint,&angle);
 	
 	pd->lua->pushFloat(xmin);
 	pd->lua->pushFloat(xmax);
@@ -239,7 +303,7 @@ static int lib3d_get_track_info(lua_State* L) {
 static int lib3d_clear_checkpoint(lua_State* L) {
 	Point3d* pos = getArgVec3(1);
 
-	clear_checkpoint(*pos);
+	clear_checkpoint(_ground, *pos);
 
 	return 0;
 }
@@ -251,7 +315,9 @@ static int lib3d_update_ground(lua_State* L) {
 
 	int slice_id;
 	TrackPattern pattern;
-	update_ground(*pos, &slice_id, &pattern, offset);
+	update_ground(_ground, *pos, &slice_id, &pattern, offset);
+	// shift particles
+	update_particles(*offset);
 
 	pd->lua->pushInt(slice_id);
 	pd->lua->pushString(pattern);
@@ -270,6 +336,12 @@ static int lib3d_add_render_prop(lua_State* L) {
 	return 0;
 }
 
+// max. slice generation time per frame (microseconds, 0: on demand)
+static int lib3d_set_generation_budget(lua_State* L) {
+	set_generation_budget(pd->lua->getArgInt(1));
+	return 0;
+}
+
 static int lib3d_collide(lua_State* L) {
 	int argc = 1;
 
@@ -277,7 +349,7 @@ static int lib3d_collide(lua_State* L) {
 	float radius = pd->lua->getArgFloat(argc++);
 
 	int out = 0;
-	collide(*pos, radius, &out);
+	collide(_ground, *pos, radius, &out);
 
 	pd->lua->pushInt(out);
 	return 1;
@@ -325,28 +397,128 @@ static int lib3d_clear_particles(lua_State* L) {
 	return 0;
 }
 
-// https://www.partow.net/programming/hashfunctions/index.html#DEKHashFunction
-static int lib3d_DEKHash(lua_State* L)
-{
+// player input recording (active ground)
+static int lib3d_start_recording(lua_State* L) {
 	int argc = 1;
-	const char* str = pd->lua->getArgString(argc++);
-	const size_t length = strlen(str);
+	SimParams params;
+	params.hp = pd->lua->getArgInt(argc++);
+	params.min_boost = pd->lua->getArgFloat(argc++);
+	params.max_boost = pd->lua->getArgFloat(argc++);
+	params.boost_t = pd->lua->getArgFloat(argc++);
+	record_start(&_recorder, get_ground_params(_ground), &params);
+	return 0;
+}
 
-	unsigned int hash = (int)length;
-	for (size_t i = 0; i < length; ++str, ++i)
-	{
-		hash = ((hash << 5) ^ (hash >> 27)) ^ (*str);
-	}
-	pd->lua->pushInt(hash);
+// returns quantized crank change (as replayed)
+static int lib3d_record_input(lua_State* L) {
+	int argc = 1;
+	const float crank = pd->lua->getArgFloat(argc++);
+	const int buttons = pd->lua->getArgInt(argc++);
+	pd->lua->pushFloat(record_input(&_recorder, crank, buttons));
+	return 1;
+}
+
+static int lib3d_save_recording(lua_State* L) {
+	record_stop(&_recorder);
+	pd->lua->pushBool(record_save(&_recorder, pd->lua->getArgString(1)));
+	return 1;
+}
+
+// raster commands of the next frames (offline rasterizer benchmarks)
+static int lib3d_capture_frames(lua_State* L) {
+	int argc = 1;
+	const char* path = pd->lua->getArgString(argc++);
+	const int frames = pd->lua->getArgInt(argc++);
+	capture_frames(path, frames > 0 ? frames : 1);
+	return 0;
+}
+
+// daily seed
+static int lib3d_DEKHash(lua_State* L)
+{
+	pd->lua->pushInt((int)dek_hash(pd->lua->getArgString(1)));
 	return 1;
 }
 
 // expose game random (for daily)
 static int lib3d_seeded_rnd(lua_State* L) {
-	pd->lua->pushFloat(randf_seeded());
+	pd->lua->pushFloat(randf_gameplay());
 	return 1;
 }
 
+// start benchmark (fixed seed ground + camera flight)
+static int lib3d_bench_init(lua_State* L) {
+	const int summary_frames = pd->lua->getArgCount() > 0 ? pd->lua->getArgInt(1) : 0;
+	start_bench(summary_frames);
+	return 0;
+}
+
+// run one benchmark frame
+static int lib3d_bench(lua_State* L) {
+	uint8_t* bitmap = pd->graphics->getFrame();
+
+	update_bench(bitmap);
+
+	pd->graphics->markUpdatedRows(0, LCD_ROWS - 1);
+	return 0;
+}
+
+// set render options (see ground.h)
+// 1: ordered ground
+// 2: front to back (S-buffer)
+// 4: ray casted visible tiles
+// 8: horizon culling
+static int lib3d_set_render_flags(lua_State* L) {
+	set_render_flags(pd->lua->getArgInt(1));
+	return 0;
+}
+
+// frame arena size (bytes), see arena.h
+// returns false if the arena could not be resized (e.g. called while rendering)
+static int lib3d_set_arena_capacity(lua_State* L) {
+	pd->lua->pushBool(arena_set_capacity(pd->lua->getArgInt(1)));
+	return 1;
+}
+
+// returns frame arena capacity, last frame usage and high water mark (bytes)
+// reset: optional, non zero restarts high water mark tracking
+static int lib3d_get_arena_stats(lua_State* L) {
+	ArenaStats stats;
+	arena_get_stats(&stats);
+	if (pd->lua->getArgCount() > 0 && pd->lua->getArgInt(1)) arena_reset_peak();
+	pd->lua->pushInt(stats.capacity);
+	pd->lua->pushInt(stats.used);
+	pd->lua->pushInt(stats.peak);
+	return 3;
+}
+
+// average render stats over the last n frames (default: 1)
+// returns sky, collect, transform, particles, sort, raster timings (ms)
+// followed by tiles, drawables, culled, clipped, scanlines, props, hidden tiles, hidden props, projected, tile vertices, sbuffer overflows counts
+// returns nil if not a profile build
+static int lib3d_get_frame_stats(lua_State* L) {
+#ifdef LIB3D_PROFILE
+	const int n = pd->lua->getArgCount() > 0 ? pd->lua->getArgInt(1) : 1;
+	FrameStatsSummary stats;
+	if (!profile_get_stats(n, &stats)) {
+		pd->lua->pushNil();
+		return 1;
+	}
+	// stage timings (ms)
+	for (int i = 0; i < PROFILE_STAGE_COUNT; i++) {
+		pd->lua->pushFloat(stats.stages[i]);
+	}
+	// counters
+	for (int i = 0; i < PROFILE_COUNTER_COUNT; i++) {
+		pd->lua->pushFloat(stats.counters[i]);
+	}
+	return PROFILE_STAGE_COUNT + PROFILE_COUNTER_COUNT;
+#else
+	pd->lua->pushNil();
+	return 1;
+#endif
+}
+
 void lib3d_register(PlaydateAPI* playdate)
 {
 	pd = playdate;
@@ -356,13 +528,24 @@ void lib3d_register(PlaydateAPI* playdate)
 
 	// init modules
 	gfx_init(playdate);
+	capture_init(playdate);
 	ground_init(playdate);
+	if (!_ground) _ground = create_ground_context();
+	visibility_init(playdate);
+	horizon_init(playdate);
 	tracks_init(playdate);
 	particles_init(playdate);
+	arena_init(playdate);
 	drawables_init(playdate);
 	lua3dmath_init(playdate);
+	bench_init(playdate);
+	profile_init(playdate);
+	sim_init(playdate);
+	record_init(playdate);
 
 	REGISTER_LUA_FUNC(make_ground);
+	REGISTER_LUA_FUNC(save_ground_state);
+	REGISTER_LUA_FUNC(restore_ground_state);
 	REGISTER_LUA_FUNC(render_ground);
 	REGISTER_LUA_FUNC(render_props);
 	REGISTER_LUA_FUNC(get_start_pos);
@@ -373,15 +556,28 @@ void lib3d_register(PlaydateAPI* playdate)
 	REGISTER_LUA_FUNC(collide);
 	REGISTER_LUA_FUNC(load_assets_async);
 	REGISTER_LUA_FUNC(update_ground);
+	REGISTER_LUA_FUNC(set_generation_budget);
 	REGISTER_LUA_FUNC(spawn_particle);
 	REGISTER_LUA_FUNC(clear_particles);
 	REGISTER_LUA_FUNC(DEKHash);
+	REGISTER_LUA_FUNC(start_recording);
+	REGISTER_LUA_FUNC(record_input);
+	REGISTER_LUA_FUNC(save_recording);
+	REGISTER_LUA_FUNC(capture_frames);
 	REGISTER_LUA_FUNC(seeded_rnd);
+	REGISTER_LUA_FUNC(bench_init);
+	REGISTER_LUA_FUNC(bench);
+	REGISTER_LUA_FUNC(get_frame_stats);
+	REGISTER_LUA_FUNC(set_render_flags);
+	REGISTER_LUA_FUNC(set_arena_capacity);
+	REGISTER_LUA_FUNC(get_arena_stats);
 	
 	if (!pd->lua->registerClass("lib3d.GroundParams", lib3D_GroundParams, NULL, 0, &err))
 		pd->system->logToConsole("%s:%i: registerClass failed, %s", __FILE__, __LINE__, err);	
 	if (!pd->lua->registerClass("lib3d.TrackPatterns", lib3D_TrackPatterns, NULL, 0, &err))
 		pd->system->logToConsole("%s:%i: registerClass failed, %s", __FILE__, __LINE__, err);
+	if (!pd->lua->registerClass("lib3d.GroundState", lib3D_GroundState, NULL, 0, &err))
+		pd->system->logToConsole("%s:%i: registerClass failed, %s", __FILE__, __LINE__, err);
 }
 
 void lib3d_unregister(PlaydateAPI* playdate) {
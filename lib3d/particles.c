@@ -128,7 +128,10 @@ void update_particles(const Point3d offset) {
 
 // particles API - rendering
 
-static void draw_particle(Drawable* drawable, uint8_t* bitmap) {
+static void draw_particle(Drawable* drawable, uint8_t* bitmap, const int pass) {
+    // transparent
+    if (pass == DRAW_PASS_OPAQUE) return;
+
     DrawableParticle* particle = &drawable->particle;
 
     // project particle center
@@ -166,7 +169,8 @@ void push_particles(const Point3d cam_pos, const Mat4 m) {
                 m_x_v(m, p->pos, &res);
                 // visible?
                 if (res.z > Z_NEAR && res.z < (float)(GROUND_CELL_SIZE * MAX_TILE_DIST)) {
-                    Drawable* drawable = pop_drawable(res.z);
+                    Drawable* drawable = pop_drawable(res.z, get_drawable_layer(p->pos.z));
+                    if (!drawable) continue;
                     drawable->draw = draw_particle;
                     drawable->key = res.z;
                     drawable->particle.pos = res;
@@ -66,4 +66,58 @@ float perlin2d(float x, float y, float freq, int depth)
     }
 
     return fin / div;
-}
\ No newline at end of file
+}
+
+void perlin2d_row(float y, float freq, int depth, float out[GROUND_WIDTH])
+{
+    float xa[GROUND_WIDTH];
+    float fin[GROUND_WIDTH];
+    for (int i = 0; i < GROUND_WIDTH; i++)
+    {
+        xa[i] = ((16.f * i) / GROUND_WIDTH) * freq;
+        fin[i] = 0;
+    }
+    float ya = y * freq;
+    float amp = 1.0;
+    float div = 0.0;
+
+    for (int k = 0; k < depth; k++)
+    {
+        // shared y row
+        const int y_int = (int)ya;
+        const float y_frac = ya - y_int;
+        const float y_s = y_frac * y_frac * (3 - 2 * y_frac);
+        const int h0 = hash[(y_int + SEED) & 255];
+        const int h1 = hash[(y_int + 1 + SEED) & 255];
+
+        // lattice lookups
+        float x_s[GROUND_WIDTH], s[GROUND_WIDTH], t[GROUND_WIDTH], u[GROUND_WIDTH], v[GROUND_WIDTH];
+        for (int i = 0; i < GROUND_WIDTH; i++)
+        {
+            const int x_int = (int)xa[i];
+            const float x_frac = xa[i] - x_int;
+            x_s[i] = x_frac * x_frac * (3 - 2 * x_frac);
+            s[i] = (float)hash[(h0 + x_int) & 255];
+            t[i] = (float)hash[(h0 + x_int + 1) & 255];
+            u[i] = (float)hash[(h1 + x_int) & 255];
+            v[i] = (float)hash[(h1 + x_int + 1) & 255];
+        }
+
+        // interpolation (no dependency across columns)
+        div += 256 * amp;
+        for (int i = 0; i < GROUND_WIDTH; i++)
+        {
+            const float low = s[i] + x_s[i] * (t[i] - s[i]);
+            const float high = u[i] + x_s[i] * (v[i] - u[i]);
+            fin[i] += (low + y_s * (high - low)) * amp;
+            xa[i] *= 2;
+        }
+        amp /= 2;
+        ya *= 2;
+    }
+
+    for (int i = 0; i < GROUND_WIDTH; i++)
+    {
+        out[i] = fin[i] / div;
+    }
+}
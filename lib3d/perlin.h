@@ -1,7 +1,14 @@
 #ifndef perlin_h
 #define perlin_h
 
+#include "ground_limits.h"
+
 // generates 2d perlin noise
 float perlin2d(float x, float y, float freq, int depth);
 
+// generates a row of 2d perlin noise (same as perlin2d)
+// out[i] = perlin2d((16.f * i) / GROUND_WIDTH, y, freq, depth)
+// note: x and y must be positive
+void perlin2d_row(float y, float freq, int depth, float out[GROUND_WIDTH]);
+
 #endif
\ No newline at end of file
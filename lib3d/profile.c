@@ -0,0 +1,149 @@
+#include "profile.h"
+
+static PlaydateAPI* pd;
+
+const char* _profile_stage_names[PROFILE_STAGE_COUNT] = { "sky", "collect", "transform", "particles", "sort", "raster" };
+const char* _profile_counter_names[PROFILE_COUNTER_COUNT] = { "tiles", "drawables", "culled", "clipped", "scanlines", "props", "hidden_tiles", "hidden_props", "projected", "tile_vertices", "sbuffer_overflows" };
+
+#ifdef LIB3D_PROFILE
+
+// ring buffer of frame stats
+static struct {
+    // slot of the frame being recorded
+    int head;
+    // number of completed frames (up to PROFILE_FRAMES)
+    int count;
+    FrameStats frames[PROFILE_FRAMES + 1];
+} _profile;
+
+FrameStats* _profile_frame = &_profile.frames[0];
+
+#if TARGET_PLAYDATE
+// Playdate CPU (STM32F7) device defines
+#define __CM7_REV 0x0001
+#define __FPU_PRESENT 1
+#define __MPU_PRESENT 1
+#define __ICACHE_PRESENT 1
+#define __DCACHE_PRESENT 1
+#define __DTCM_PRESENT 1
+#define __NVIC_PRIO_BITS 4
+#define __Vendor_SysTickConfig 0
+typedef enum {
+    NonMaskableInt_IRQn = -14,
+    SysTick_IRQn = -1
+} IRQn_Type;
+#include "core_cm7.h"
+
+// cycle counter rate, measured against the system milliseconds clock
+static struct {
+    float hz;
+    // start of measurement window
+    uint32_t cycles;
+    unsigned int ms;
+} _clock;
+
+// shortest & longest window (cycle counter wraps every ~25s)
+#define PROFILE_CLOCK_MIN_MS 1000
+#define PROFILE_CLOCK_MAX_MS 10000
+
+static void start_clock_window() {
+    _clock.ms = pd->system->getCurrentTimeMilliseconds();
+    _clock.cycles = DWT->CYCCNT;
+}
+
+// first estimate: cycles between 2 millisecond ticks, 16ms apart
+static void calibrate_clock() {
+    unsigned int ms = pd->system->getCurrentTimeMilliseconds();
+    while (pd->system->getCurrentTimeMilliseconds() == ms);
+    start_clock_window();
+    while (pd->system->getCurrentTimeMilliseconds() - _clock.ms < 16);
+    _clock.hz = (DWT->CYCCNT - _clock.cycles) * (1000.f / 16.f);
+    start_clock_window();
+}
+
+// refine rate over long windows
+static void update_clock() {
+    const unsigned int dms = pd->system->getCurrentTimeMilliseconds() - _clock.ms;
+    if (dms < PROFILE_CLOCK_MIN_MS) return;
+    if (dms <= PROFILE_CLOCK_MAX_MS) _clock.hz = (DWT->CYCCNT - _clock.cycles) * 1000.f / dms;
+    start_clock_window();
+}
+#endif
+
+// note: float elapsed time loses precision as it grows, cycle counter does not
+uint32_t profile_ticks() {
+#if TARGET_PLAYDATE
+    return DWT->CYCCNT;
+#else
+    // microseconds
+    return (uint32_t)(1000000.0 * pd->system->getElapsedTime());
+#endif
+}
+
+float profile_seconds(const uint32_t t0, const uint32_t t1) {
+    // note: unsigned difference is wrap-around safe
+#if TARGET_PLAYDATE
+    return (float)(t1 - t0) / _clock.hz;
+#else
+    return (float)(t1 - t0) / 1000000.f;
+#endif
+}
+
+void profile_begin_frame() {
+#if TARGET_PLAYDATE
+    update_clock();
+#endif
+    _profile_frame = &_profile.frames[_profile.head];
+    memset(_profile_frame, 0, sizeof(FrameStats));
+}
+
+void profile_end_frame() {
+    // note: ring is 1 larger than history to keep active frame out of stats
+    _profile.head = (_profile.head + 1) % (PROFILE_FRAMES + 1);
+    if (_profile.count < PROFILE_FRAMES) _profile.count++;
+    // anything outside a frame goes into next slot
+    _profile_frame = &_profile.frames[_profile.head];
+}
+
+int profile_get_stats(int n, FrameStatsSummary* out) {
+    memset(out, 0, sizeof(FrameStatsSummary));
+    if (n > _profile.count) n = _profile.count;
+    if (n <= 0) return 0;
+
+    int k = _profile.head;
+    for (int i = 0; i < n; i++) {
+        k = (k + PROFILE_FRAMES) % (PROFILE_FRAMES + 1);
+        const FrameStats* frame = &_profile.frames[k];
+        for (int j = 0; j < PROFILE_STAGE_COUNT; j++) {
+            out->stages[j] += frame->stages[j];
+        }
+        for (int j = 0; j < PROFILE_COUNTER_COUNT; j++) {
+            out->counters[j] += (float)frame->counters[j];
+        }
+    }
+    for (int j = 0; j < PROFILE_STAGE_COUNT; j++) {
+        out->stages[j] *= 1000.f / n;
+    }
+    for (int j = 0; j < PROFILE_COUNTER_COUNT; j++) {
+        out->counters[j] /= n;
+    }
+    out->frames = n;
+    return n;
+}
+
+#endif
+
+void profile_init(PlaydateAPI* playdate) {
+    pd = playdate;
+#ifdef LIB3D_PROFILE
+#if TARGET_PLAYDATE
+    // enable cycle counter (profile builds only)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    calibrate_clock();
+#endif
+    _profile.head = 0;
+    _profile.count = 0;
+    _profile_frame = &_profile.frames[0];
+#endif
+}
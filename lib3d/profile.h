@@ -0,0 +1,95 @@
+#ifndef _profile_h
+#define _profile_h
+
+#include <pd_api.h>
+
+// frame profiler
+// compiled only when LIB3D_PROFILE is defined, all macros are no-op otherwise
+
+// number of frames kept in history
+#define PROFILE_FRAMES 64
+
+// timed stages (in render order)
+#define PROFILE_STAGE_SKY 0
+#define PROFILE_STAGE_COLLECT 1
+#define PROFILE_STAGE_TRANSFORM 2
+#define PROFILE_STAGE_PARTICLES 3
+#define PROFILE_STAGE_SORT 4
+#define PROFILE_STAGE_RASTER 5
+#define PROFILE_STAGE_COUNT 6
+
+// counters
+#define PROFILE_COUNTER_TILES 0
+#define PROFILE_COUNTER_DRAWABLES 1
+#define PROFILE_COUNTER_CULLED 2
+#define PROFILE_COUNTER_CLIPPED 3
+#define PROFILE_COUNTER_SCANLINES 4
+#define PROFILE_COUNTER_PROPS 5
+// horizon culling
+#define PROFILE_COUNTER_HIDDEN_TILES 6
+#define PROFILE_COUNTER_HIDDEN_PROPS 7
+// ground tiles: perspective divides vs. vertices of visible tiles
+#define PROFILE_COUNTER_PROJECTED 8
+#define PROFILE_COUNTER_TILE_VERTICES 9
+// S-buffer scanlines out of spans or pieces (drawn but not marked as covered)
+#define PROFILE_COUNTER_SBUFFER_OVERFLOWS 10
+#define PROFILE_COUNTER_COUNT 11
+
+typedef struct {
+    // seconds
+    float stages[PROFILE_STAGE_COUNT];
+    int counters[PROFILE_COUNTER_COUNT];
+} FrameStats;
+
+// average stats (stages & counters)
+typedef struct {
+    int frames;
+    // milliseconds
+    float stages[PROFILE_STAGE_COUNT];
+    float counters[PROFILE_COUNTER_COUNT];
+} FrameStatsSummary;
+
+extern const char* _profile_stage_names[PROFILE_STAGE_COUNT];
+extern const char* _profile_counter_names[PROFILE_COUNTER_COUNT];
+
+#ifdef LIB3D_PROFILE
+
+// frame being recorded
+extern FrameStats* _profile_frame;
+
+// profiler clock
+// device: CPU cycle counter (wraps every ~25s, only suitable for intervals), rate measured against system time
+// simulator: system elapsed time
+uint32_t profile_ticks();
+// seconds from ticks t0 to t1
+float profile_seconds(const uint32_t t0, const uint32_t t1);
+
+// clear next frame slot
+void profile_begin_frame();
+// commit active frame to history
+void profile_end_frame();
+
+// average of the last n completed frames
+// returns the actual number of frames averaged
+int profile_get_stats(int n, FrameStatsSummary* out);
+
+#define PROFILE_BEGIN_FRAME() profile_begin_frame()
+#define PROFILE_END_FRAME() profile_end_frame()
+#define PROFILE_ZONE_BEGIN(stage) const uint32_t _profile_zone_##stage = profile_ticks()
+#define PROFILE_ZONE_END(stage) (_profile_frame->stages[stage] += profile_seconds(_profile_zone_##stage, profile_ticks()))
+#define PROFILE_COUNT(counter, n) (_profile_frame->counters[counter] += (n))
+
+#else
+
+#define PROFILE_BEGIN_FRAME()
+#define PROFILE_END_FRAME()
+#define PROFILE_ZONE_BEGIN(stage)
+#define PROFILE_ZONE_END(stage)
+#define PROFILE_COUNT(counter, n)
+
+#endif
+
+// init module
+void profile_init(PlaydateAPI* playdate);
+
+#endif
@@ -1,11 +1,12 @@
 #include <stdlib.h>
+#include <string.h>
 #include "rand_r.h"
 
-// single context (no thread here!)
-static int _seed;
+// gameplay rolls (independent from ground generation timing)
+static int _gameplay_seed;
 
 void rand_r_init(int seed) {
-  _seed = seed;
+  _gameplay_seed = seed ^ 0x2545f491;
 }
 
 static int rand_next(int* seed) {
@@ -13,24 +14,51 @@ static int rand_next(int* seed) {
     return (*seed / 65536) & 32767;
 }
 
+// splitmix64 finalizer
+static inline uint64_t mix64(uint64_t z) {
+    z += 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+uint32_t rand_hash(const uint32_t seed, const uint32_t slice, const uint32_t column, const uint32_t purpose) {
+    const uint64_t h = mix64(((uint64_t)seed << 32) | slice);
+    return (uint32_t)(mix64(h ^ (((uint64_t)column << 32) | purpose)) >> 32);
+}
+
 // returns a random number between [0-1[
-float randf_seeded() {
-  return rand_next(&_seed) / 32768.f;
+float randf_at(const int seed, const int slice, const int column, const int purpose) {
+  return (rand_hash((uint32_t)seed, (uint32_t)slice, (uint32_t)column, (uint32_t)purpose) >> 8) / 16777216.f;
 }
 
 // returns a rand number between [0;max[
-int randi_seeded(const int max) {
-    return rand_next(&_seed) % max;
+int randi_at(const int max, const int seed, const int slice, const int column, const int purpose) {
+    return (int)(((uint64_t)rand_hash((uint32_t)seed, (uint32_t)slice, (uint32_t)column, (uint32_t)purpose) * (uint32_t)max) >> 32);
 }
 
-void shuffle_seeded(int* array, const size_t n)
+void shuffle_at(int* array, const size_t n, const int seed, const int slice, const int purpose)
 {
     if (n > 1) {
         for (size_t i = 0; i < n - 1; i++) {
-            const size_t j = i + rand_next(&_seed) / (RAND_MAX / (n - i) + 1);
+            const size_t j = i + randi_at((int)(n - i), seed, slice, (int)i, purpose);
             const int t = array[j];
             array[j] = array[i];
             array[i] = t;
         }
     }
-}
\ No newline at end of file
+}
+
+// returns a random number between [0-1[ (gameplay sequence)
+float randf_gameplay() {
+  return rand_next(&_gameplay_seed) / 32768.f;
+}
+
+uint32_t dek_hash(const char* str) {
+  const size_t length = strlen(str);
+  uint32_t hash = (uint32_t)length;
+  for (size_t i = 0; i < length; ++str, ++i) {
+    hash = ((hash << 5) ^ (hash >> 27)) ^ (*str);
+  }
+  return hash;
+}
@@ -1,16 +1,52 @@
 #ifndef _lib3d_randr_h
 #define _lib3d_randr_h
 
-// initialize seed
+#include <stdint.h>
+
+// course generation streams (purpose)
+// ground
+#define RAND_SLICE_Y 0
+#define RAND_SLICE_NOISE 1
+#define RAND_PROP 2
+#define RAND_PROP_ID 3
+#define RAND_PROP_T 4
+#define RAND_COIN 5
+#define RAND_WALL 6
+#define RAND_WALL_BLEND 7
+// tracks
+#define RAND_TRACK_START 8
+#define RAND_TRACK_TTL 9
+#define RAND_TRACK_TRICK_TTL 10
+#define RAND_TRACK_TRICK_TYPE 11
+#define RAND_TRACK_TWIST 12
+#define RAND_TRACK_SPAWN 13
+#define RAND_SECTION 14
+#define RAND_SECTION_LANES 15
+#define RAND_SECTION_COOLDOWN 16
+
+// initialize gameplay sequence
 void rand_r_init(int seed);
 
-// returns a random number between 0-1
-float randf_seeded();
+// counter based generator (stateless)
+// returns a 32bits hash of (seed, slice, column, purpose)
+uint32_t rand_hash(const uint32_t seed, const uint32_t slice, const uint32_t column, const uint32_t purpose);
+
+// returns a random number between [0;1[
+// note: pure function of (seed, slice, column, purpose), any slice can be generated out of order
+float randf_at(const int seed, const int slice, const int column, const int purpose);
 
 // returns a rand number between [0;max[
-int randi_seeded(const int max);
+int randi_at(const int max, const int seed, const int slice, const int column, const int purpose);
 
-// 
-void shuffle_seeded(int* array, const size_t n);
+// shuffle array (column: array index)
+void shuffle_at(int* array, const size_t n, const int seed, const int slice, const int purpose);
+
+// DEK string hash (daily seed)
+// https://www.partow.net/programming/hashfunctions/index.html#DEKHashFunction
+uint32_t dek_hash(const char* str);
+
+// returns a random number between 0-1
+// separate sequence: ground is generated ahead of time
+float randf_gameplay();
 
-#endif
\ No newline at end of file
+#endif
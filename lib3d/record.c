@@ -0,0 +1,151 @@
+#include "record.h"
+#include "realloc.h"
+
+static PlaydateAPI* pd;
+
+static const char _magic[4] = { 'M', 'W', 'I', 'R' };
+
+// signed delta to unsigned (small deltas: small values)
+static uint32_t zigzag(const int v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int unzigzag(const uint32_t v) {
+    return (int)(v >> 1) ^ -(int)(v & 1);
+}
+
+static void push_byte(InputRecorder* recorder, const uint8_t b) {
+    if (recorder->size == recorder->capacity) {
+        recorder->capacity = recorder->capacity ? 2 * recorder->capacity : 4096;
+        recorder->data = lib3d_realloc(recorder->data, recorder->capacity);
+    }
+    recorder->data[recorder->size++] = b;
+}
+
+static void push_varint(InputRecorder* recorder, uint32_t v) {
+    while (v >= 0x80) {
+        push_byte(recorder, (uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    push_byte(recorder, (uint8_t)v);
+}
+
+void record_start(InputRecorder* recorder, const GroundParams* ground, const SimParams* sim) {
+    recorder->active = 1;
+    memcpy(recorder->header.magic, _magic, sizeof(_magic));
+    recorder->header.version = RECORD_VERSION;
+    recorder->header.frames = 0;
+    recorder->header.ground = *ground;
+    recorder->header.sim = *sim;
+    recorder->prev_crank = 0;
+    recorder->prev_buttons = 0;
+    recorder->size = 0;
+}
+
+float record_input(InputRecorder* recorder, const float crank, const int buttons) {
+    const int q = (int)lroundf(crank * RECORD_CRANK_SCALE);
+    if (recorder->active) {
+        const int changed = buttons != recorder->prev_buttons;
+        push_varint(recorder, (zigzag(q - recorder->prev_crank) << 1) | changed);
+        if (changed) push_byte(recorder, (uint8_t)buttons);
+        recorder->prev_crank = q;
+        recorder->prev_buttons = buttons;
+        recorder->header.frames++;
+    }
+    return q / RECORD_CRANK_SCALE;
+}
+
+void record_stop(InputRecorder* recorder) {
+    recorder->active = 0;
+}
+
+void record_free(InputRecorder* recorder) {
+    lib3d_free(recorder->data);
+    recorder->data = NULL;
+    recorder->size = recorder->capacity = 0;
+    recorder->active = 0;
+}
+
+int record_save(const InputRecorder* recorder, const char* path) {
+    SDFile* file = pd->file->open(path, kFileWrite);
+    if (!file) {
+        pd->system->logToConsole("Unable to create: %s (%s)", path, pd->file->geterr());
+        return 0;
+    }
+    int res = pd->file->write(file, &recorder->header, sizeof(RecordHeader)) == sizeof(RecordHeader);
+    if (res && recorder->size) res = pd->file->write(file, recorder->data, recorder->size) == recorder->size;
+    pd->file->close(file);
+    if (!res) pd->system->logToConsole("Unable to write: %s (%s)", path, pd->file->geterr());
+    return res;
+}
+
+uint8_t* record_load(const char* path, int* size) {
+    SDFile* file = pd->file->open(path, kFileRead | kFileReadData);
+    if (!file) {
+        pd->system->logToConsole("Unable to open: %s (%s)", path, pd->file->geterr());
+        return NULL;
+    }
+    int capacity = 4096;
+    uint8_t* data = lib3d_malloc(capacity);
+    *size = 0;
+    int n;
+    while ((n = pd->file->read(file, data + *size, capacity - *size)) > 0) {
+        *size += n;
+        if (*size == capacity) {
+            capacity *= 2;
+            data = lib3d_realloc(data, capacity);
+        }
+    }
+    pd->file->close(file);
+    if (n < 0) {
+        pd->system->logToConsole("Unable to read: %s (%s)", path, pd->file->geterr());
+        lib3d_free(data);
+        return NULL;
+    }
+    return data;
+}
+
+int replay_start(InputReplay* replay, const uint8_t* data, const int size) {
+    if (size < (int)sizeof(RecordHeader)) return 0;
+    memcpy(&replay->header, data, sizeof(RecordHeader));
+    if (memcmp(replay->header.magic, _magic, sizeof(_magic)) || replay->header.version != RECORD_VERSION) {
+        pd->system->logToConsole("Invalid recording version: %i (expected: %i)", replay->header.version, RECORD_VERSION);
+        return 0;
+    }
+    replay->data = data + sizeof(RecordHeader);
+    replay->size = size - (int)sizeof(RecordHeader);
+    replay->pos = 0;
+    replay->frame = 0;
+    replay->prev_crank = 0;
+    replay->prev_buttons = 0;
+    return 1;
+}
+
+int replay_next(InputReplay* replay, SimInput* input) {
+    if (replay->frame >= replay->header.frames) return 0;
+
+    uint32_t token = 0;
+    for (int shift = 0; ; shift += 7) {
+        if (replay->pos >= replay->size || shift > 28) return 0;
+        const uint8_t b = replay->data[replay->pos++];
+        token |= (uint32_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) break;
+    }
+    int buttons = replay->prev_buttons;
+    if (token & 1) {
+        if (replay->pos >= replay->size) return 0;
+        buttons = replay->data[replay->pos++];
+    }
+    replay->prev_crank += unzigzag(token >> 1);
+
+    input->crank = replay->prev_crank / RECORD_CRANK_SCALE;
+    // just pressed
+    input->buttons = (buttons & ~replay->prev_buttons & RECORD_BUTTON_ACTION) ? SIM_BUTTON_JUMP : 0;
+    replay->prev_buttons = buttons;
+    replay->frame++;
+    return 1;
+}
+
+void record_init(PlaydateAPI* playdate) {
+    pd = playdate;
+}
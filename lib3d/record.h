@@ -0,0 +1,79 @@
+#ifndef _record_h
+#define _record_h
+
+#include <pd_api.h>
+#include "ground.h"
+#include "sim.h"
+
+// player input recordings
+// header (course + player parameters) followed by one delta encoded token per frame:
+// varint(zigzag(crank delta) << 1 | buttons changed) [+ buttons byte]
+#define RECORD_VERSION 1
+// crank change resolution (1/16 degree)
+#define RECORD_CRANK_SCALE 16.f
+
+// recorded buttons (held state)
+#define RECORD_BUTTON_ACTION 1
+
+typedef struct {
+    char magic[4];
+    int version;
+    int frames;
+    GroundParams ground;
+    SimParams sim;
+} RecordHeader;
+
+typedef struct {
+    int active;
+    RecordHeader header;
+    int prev_crank;
+    int prev_buttons;
+    int size;
+    int capacity;
+    uint8_t* data;
+} InputRecorder;
+
+typedef struct {
+    RecordHeader header;
+    const uint8_t* data;
+    int size;
+    // read cursor
+    int pos;
+    int frame;
+    int prev_crank;
+    int prev_buttons;
+} InputReplay;
+
+// start a new recording (previous frames are discarded)
+void record_start(InputRecorder* recorder, const GroundParams* ground, const SimParams* sim);
+
+// record one frame of input
+// returns the quantized crank change (to be used by game to match replays)
+float record_input(InputRecorder* recorder, const float crank, const int buttons);
+
+// stop recording (frames are kept)
+void record_stop(InputRecorder* recorder);
+
+// release recorder memory
+void record_free(InputRecorder* recorder);
+
+// write recording to file
+// returns 0 on failure
+int record_save(const InputRecorder* recorder, const char* path);
+
+// load recording file (buffer to be freed with lib3d_free)
+// returns NULL on failure
+uint8_t* record_load(const char* path, int* size);
+
+// start replay of an encoded recording (header + frames)
+// returns 0 if recording is invalid
+int replay_start(InputReplay* replay, const uint8_t* data, const int size);
+
+// next frame of input (buttons: SIM_BUTTON_xxx pressed this frame)
+// returns 0 at end of recording
+int replay_next(InputReplay* replay, SimInput* input);
+
+// init module
+void record_init(PlaydateAPI* playdate);
+
+#endif
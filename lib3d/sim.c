@@ -0,0 +1,356 @@
+#include "sim.h"
+
+static PlaydateAPI* pd;
+
+// note: lua main.lua angles are in turns and lua sin is inverted (pico-8 convention)
+#define SIM_DT (0.5f / SIM_FPS)
+
+static const Point3d _gravity = { .v = { 0.f, -3.5f, 0.f } };
+
+static float midf(const float a, const float b, const float c) {
+    return fminf(fmaxf(a, b), c);
+}
+
+// lua lerp
+static float lerp_lua(const float a, const float b, const float t) {
+    return a * (1.f - t) + b * t;
+}
+
+// make_m_from_v_angle right & fwd vectors
+static void make_basis(const Point3d up, const float tau_angle, Point3d* right, Point3d* fwd) {
+    const float angle = detauify(tau_angle);
+    Point3d f = { .v = { sinf(angle), 0.f, cosf(angle) } };
+    v_cross(up, f, right);
+    v_normz(right);
+    v_cross(*right, up, fwd);
+}
+
+static void apply_force_and_torque(SimBody* body, const Point3d f, const float t) {
+    for (int i = 0; i < 3; i++) body->forces.v[i] += f.v[i];
+    body->torque += t;
+}
+
+static void integrate_body(SimBody* body) {
+    // gravity and ground
+    apply_force_and_torque(body, _gravity, 0.f);
+    if (body->on_ground) {
+        // slope pushing up
+        Point3d up_force = body->up;
+        const float scale = -v_dot(up_force, _gravity);
+        for (int i = 0; i < 3; i++) up_force.v[i] *= scale;
+        apply_force_and_torque(body, up_force, 0.f);
+    }
+
+    // update velocities
+    Point3d* velocity = &body->velocity;
+    for (int i = 0; i < 3; i++) velocity->v[i] += SIM_DT * body->forces.v[i];
+    body->angularv += body->torque * SIM_DT;
+
+    // apply some damping
+    body->angularv *= 0.86f;
+    body->drag *= 0.9f;
+    // kill boost while on ground
+    if (body->on_ground) body->boost *= 0.9f;
+    // some friction
+    const float f = body->on_ground ? 0.08f : 0.01f;
+    const float friction = -(f + body->drag) * v_dot(*velocity, *velocity);
+    for (int i = 0; i < 3; i++) velocity->v[i] += friction * velocity->v[i];
+
+    // update pos & orientation
+    const float scale = 1.f + body->boost + body->perm_boost;
+    for (int i = 0; i < 3; i++) body->pos.v[i] += scale * velocity->v[i];
+
+    // limit rotating velocity
+    body->angularv = midf(body->angularv, -1.f, 1.f);
+    body->angle += body->angularv;
+
+    // reset
+    body->forces = (Point3d){ .v = { 0 } };
+    body->torque = 0.f;
+}
+
+static void steer_body(SimBody* body, float steering_dt) {
+    // stiff direction when boosting!
+    if (body->boost > 0.1f) steering_dt /= 2.f;
+    body->steering_angle += midf(steering_dt, -0.15f, 0.15f);
+
+    const Point3d velocity = body->velocity;
+    if (body->on_ground && sqrtf(v_dot(velocity, velocity)) > 0.001f) {
+        // desired ski direction
+        Point3d right, fwd;
+        make_basis(body->up, body->angle - body->steering_angle / 16.f, &right, &fwd);
+
+        // slip angle
+        float sa = -v_dot(velocity, right);
+        if (fabsf(sa) > 0.001f) {
+            // max grip
+            Point3d vn = velocity;
+            v_normz(&vn);
+            const float grip = 1.f - fabsf(v_dot(fwd, vn));
+            // more turn: more grip
+            sa = midf(sa * 60.f * grip, -3.f, 3.f);
+
+            // ski length for torque
+            const float ski_len = 0.8f;
+            for (int i = 0; i < 3; i++) right.v[i] *= sa;
+            apply_force_and_torque(body, right, -body->steering_angle * ski_len / 4.f);
+        }
+    }
+    else if (!body->on_ground) {
+        apply_force_and_torque(body, (Point3d) { .v = { 0 } }, -body->steering_angle / 4.f);
+    }
+}
+
+// find ground & stop at ground
+static void update_body(const GroundContext* ground, SimBody* body) {
+    body->steering_angle *= body->on_ground ? 0.8f : 0.85f;
+
+    Point3d* pos = &body->pos;
+    Point3d n;
+    float y;
+    body->on_ground = 0;
+    body->on_cliff = 0;
+    float tgt_height = 1.f;
+    if (get_face(ground, *pos, &n, &y)) {
+        body->on_cliff = n.y < 0.5f;
+        if (pos->y <= y) {
+            body->up = n;
+            tgt_height = pos->y - y;
+            pos->y = y;
+            body->on_ground = 1;
+        }
+    }
+    body->height = lerp_lua(body->height, tgt_height, 0.4f);
+}
+
+static int register_trick(SimPlayer* plyr, const int trick) {
+    plyr->tricks++;
+    // add to combo only if different trick
+    if (plyr->combo_n == 0 || plyr->combo[plyr->combo_n - 1] != trick) {
+        if (plyr->combo_n < SIM_MAX_COMBO) plyr->combo[plyr->combo_n++] = trick;
+        // 3s to get another trick
+        plyr->combo_ttl = 3 * SIM_FPS;
+    }
+    return SIM_EVENT_TRICK;
+}
+
+static int control_plyr(SimPlayer* plyr, const SimInput* input) {
+    SimBody* body = &plyr->body;
+    int events = 0;
+    float da = input->crank;
+    // inverted controls?
+    if (plyr->invert_ttl > 0) da = -da;
+
+    if (body->on_ground) {
+        // was flying?
+        if (plyr->air_t > 30) {
+            // pro trick? :)
+            events |= register_trick(plyr, plyr->reverse_t > 0 ? SIM_TRICK_REVERSE_AIR : SIM_TRICK_AIR);
+        }
+        plyr->air_t = 0;
+
+        if (plyr->jump_ttl > 8 && (input->buttons & SIM_BUTTON_JUMP)) {
+            apply_force_and_torque(body, (Point3d) { .v = { 0.f, 56.f, 0.f } }, 0.f);
+            plyr->jump_ttl = 0;
+        }
+    }
+    else {
+        // avoid auto-jump on land
+        plyr->jump_ttl = 4;
+        // record flying time
+        plyr->air_t++;
+    }
+    if (++plyr->jump_ttl > 9) plyr->jump_ttl = 9;
+
+    steer_body(body, da / 8.f);
+    return events;
+}
+
+static int update_plyr(GroundContext* ground, SimPlayer* plyr) {
+    SimBody* body = &plyr->body;
+    int events = 0;
+    plyr->hit_ttl--;
+    plyr->invert_ttl--;
+
+    // spin detection
+    const float angle = body->angle;
+    if (!plyr->is_spinning) {
+        plyr->spin_angle = 0.f;
+        plyr->spin_prev = angle;
+        plyr->is_spinning = 1;
+    }
+    else {
+        float da = plyr->spin_prev - angle;
+        // shortest angle
+        if (fabsf(da) > 0.5f) da += 0.5f;
+        // doing nothing or breaking the spin?
+        if (fabsf(plyr->spin_angle) >= fabsf(plyr->spin_angle + da)) {
+            plyr->is_spinning = 0;
+        }
+        else {
+            plyr->spin_angle += da;
+            plyr->spin_prev = angle;
+        }
+    }
+    if (fabsf(plyr->spin_angle) > 1.f) {
+        events |= register_trick(plyr, SIM_TRICK_360);
+        plyr->is_spinning = 0;
+    }
+
+    int hit_type;
+    collide(ground, body->pos, 0.2f, &hit_type);
+    switch (hit_type) {
+    case 2:
+        // walls: insta-death
+        plyr->dead = 1;
+        break;
+    case 3:
+        plyr->coins++;
+        events |= SIM_EVENT_COIN;
+        break;
+    case 4:
+        // accel pad
+        if (body->on_ground) {
+            body->boost = 1.5f;
+            events |= SIM_EVENT_BOOST;
+        }
+        break;
+    case 5:
+        if (!body->on_ground) {
+            events |= register_trick(plyr, plyr->reverse_t > 0 ? SIM_TRICK_REVERSE_OVER : SIM_TRICK_JUMP_OVER);
+        }
+        break;
+    case 1:
+        if (plyr->hit_ttl < 0) {
+            // temporary invincibility
+            plyr->hit_ttl = 15;
+            plyr->hp--;
+            // kill tricks
+            plyr->reverse_t = 0;
+            plyr->is_spinning = 0;
+            events |= SIM_EVENT_HIT;
+        }
+        break;
+    }
+
+    // need to have some speed
+    const float a = detauify(angle);
+    if (v_dot(body->velocity, (Point3d) { .v = { sinf(a), 0.f, cosf(a) } }) < -0.2f) {
+        plyr->reverse_t++;
+    }
+    else {
+        plyr->reverse_t = 0;
+    }
+    if (plyr->reverse_t > 30) {
+        events |= register_trick(plyr, SIM_TRICK_REVERSE);
+        plyr->reverse_t = 0;
+    }
+
+    if (plyr->hp <= 0) plyr->dead = 1;
+
+    update_body(ground, body);
+
+    // prevent "hill" climbing!
+    if (body->on_cliff) plyr->dead = 1;
+
+    // total distance
+    // 2: crude 1 game unit = 2 meters
+    plyr->distance += fmaxf(0.f, 2.f * body->velocity.z);
+
+    return events;
+}
+
+void sim_start(const GroundContext* ground, const SimParams* params, SimPlayer* plyr) {
+    memset(plyr, 0, sizeof(SimPlayer));
+    plyr->params = *params;
+    plyr->hp = params->hp;
+    plyr->hit_ttl = 8;
+
+    SimBody* body = &plyr->body;
+    get_start_pos(ground, &body->pos);
+    body->up = (Point3d){ .v = { 0.f, 1.f, 0.f } };
+}
+
+int sim_step(GroundContext* ground, SimPlayer* plyr, const SimInput* input) {
+    if (plyr->dead) return SIM_EVENT_DEAD;
+
+    SimBody* body = &plyr->body;
+    // note: same as lua, ramp is not clamped
+    if (plyr->params.boost_t > 0.f) {
+        body->perm_boost = lerp_lua(plyr->params.min_boost, plyr->params.max_boost, (float)plyr->frame / SIM_FPS / plyr->params.boost_t);
+    }
+
+    int events = control_plyr(plyr, input);
+    integrate_body(body);
+    events |= update_plyr(ground, plyr);
+
+    // adjust ground
+    int slice_id;
+    TrackPattern pattern;
+    Point3d offset;
+    update_ground(ground, body->pos, &slice_id, &pattern, &offset);
+    for (int i = 0; i < 3; i++) body->pos.v[i] += offset.v[i];
+
+    // combo gains
+    plyr->combo_ttl--;
+    if (plyr->combo_ttl < 0 || plyr->combo_n > 9) {
+        plyr->combo_ttl = 0;
+        if (plyr->combo_n > 0) {
+            plyr->coins += plyr->combo_n * plyr->combo_n;
+            plyr->combo_n = 0;
+            events |= SIM_EVENT_COMBO;
+        }
+    }
+
+    plyr->frame++;
+    if (plyr->dead) events |= SIM_EVENT_DEAD;
+    return events;
+}
+
+void sim_start_camera(SimCamera* cam) {
+    memset(cam, 0, sizeof(SimCamera));
+    cam->up = (Point3d){ .v = { 0.f, 1.f, 0.f } };
+}
+
+void sim_update_camera(const SimPlayer* plyr, SimCamera* cam) {
+    const SimBody* body = &plyr->body;
+    const Point3d v_up = { .v = { 0.f, 1.f, 0.f } };
+
+    // player up: compensate slope when not facing slope
+    const float scale = fabsf(cosf(detauify(body->angle)));
+    Point3d u, right, fwd;
+    v_lerp(v_up, body->up, scale, &u);
+    make_basis(u, body->angle, &right, &fwd);
+    const float lean = -sinf(detauify(body->steering_angle)) * scale / 2.f;
+    for (int i = 0; i < 3; i++) u.v[i] += lean * right.v[i];
+    v_normz(&u);
+
+    // lerp angle & orientation
+    cam->angle = lerp_lua(cam->angle, body->angle, 0.8f);
+    v_lerp(cam->up, u, 0.1f, &cam->up);
+    v_normz(&cam->up);
+
+    // 1.2m above player
+    const Point3d up = cam->up;
+    make_basis(up, cam->angle, &right, &fwd);
+    cam->pos = body->pos;
+    cam->pos.y += 0.5f;
+    for (int i = 0; i < 3; i++) cam->pos.v[i] += 1.2f * up.v[i];
+
+    // inverse view matrix
+    const Mat4 r = {
+        right.x, up.x, fwd.x, 0.f,
+        right.y, up.y, fwd.y, 0.f,
+        right.z, up.z, fwd.z, 0.f,
+        0.f, 0.f, 0.f, 1.f };
+    m_x_m(r, (Mat4) {
+        1.f, 0.f, 0.f, 0.f,
+        0.f, 1.f, 0.f, 0.f,
+        0.f, 0.f, 1.f, 0.f,
+        -cam->pos.x, -cam->pos.y, -cam->pos.z, 1.f
+    }, cam->m);
+}
+
+void sim_init(PlaydateAPI* playdate) {
+    pd = playdate;
+}
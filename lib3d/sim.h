@@ -0,0 +1,123 @@
+#ifndef _sim_h
+#define _sim_h
+
+#include <pd_api.h>
+#include "3dmath.h"
+#include "ground.h"
+
+// headless player simulation (same rules as lua make_body/make_plyr)
+// fixed timestep: 1 step = 1 game frame (30Hz)
+#define SIM_FPS 30
+
+// input buttons
+#define SIM_BUTTON_JUMP 1
+
+// tricks
+#define SIM_TRICK_AIR 0
+#define SIM_TRICK_REVERSE_AIR 1
+#define SIM_TRICK_360 2
+#define SIM_TRICK_REVERSE 3
+#define SIM_TRICK_JUMP_OVER 4
+#define SIM_TRICK_REVERSE_OVER 5
+#define SIM_TRICK_COUNT 6
+
+// combo is cashed in when more than 9 tricks (or after 3s without a new trick)
+#define SIM_MAX_COMBO 16
+
+// step events
+#define SIM_EVENT_TRICK 1
+#define SIM_EVENT_COIN 2
+#define SIM_EVENT_HIT 4
+#define SIM_EVENT_BOOST 8
+#define SIM_EVENT_COMBO 16
+#define SIM_EVENT_DEAD 32
+
+typedef struct {
+    // steering (accelerated crank change in degrees or +/-1 for d-pad left/right)
+    float crank;
+    // pressed this frame (SIM_BUTTON_xxx)
+    int buttons;
+} SimInput;
+
+typedef struct {
+    int hp;
+    // permanent boost ramp (boost_t: seconds, 0: no boost)
+    float min_boost;
+    float max_boost;
+    float boost_t;
+} SimParams;
+
+// gravity + slope physic body
+typedef struct {
+    Point3d pos;
+    // last contact normal
+    Point3d up;
+    Point3d velocity;
+    Point3d forces;
+    float torque;
+    float angularv;
+    // heading (tau)
+    float angle;
+    float steering_angle;
+    float boost;
+    float perm_boost;
+    float drag;
+    // smoothed height above ground
+    float height;
+    int on_ground;
+    int on_cliff;
+} SimBody;
+
+typedef struct {
+    SimParams params;
+    SimBody body;
+    int frame;
+    int hp;
+    int dead;
+    int hit_ttl;
+    int jump_ttl;
+    int invert_ttl;
+    // spin tracking (spin_prev valid if is_spinning)
+    int is_spinning;
+    float spin_angle;
+    float spin_prev;
+    // frames going backward/in the air
+    int reverse_t;
+    int air_t;
+    // active combo
+    int combo_ttl;
+    int combo_n;
+    int combo[SIM_MAX_COMBO];
+    // score
+    float distance;
+    int coins;
+    int tricks;
+} SimPlayer;
+
+// player camera (same as lua cam:track)
+typedef struct {
+    Point3d pos;
+    // heading (tau)
+    float angle;
+    Point3d up;
+    // inverse view matrix
+    Mat4 m;
+} SimCamera;
+
+// reset player at ground start position (to be called after make_ground)
+void sim_start(const GroundContext* ground, const SimParams* params, SimPlayer* plyr);
+
+// advance player & ground by one frame
+// returns step events (SIM_EVENT_xxx)
+int sim_step(GroundContext* ground, SimPlayer* plyr, const SimInput* input);
+
+// reset camera (world up, facing down the slope)
+void sim_start_camera(SimCamera* cam);
+
+// track player (to be called after sim_step)
+void sim_update_camera(const SimPlayer* plyr, SimCamera* cam);
+
+// init module
+void sim_init(PlaydateAPI* playdate);
+
+#endif
@@ -2,19 +2,17 @@
 #include <limits.h>
 #include "tracks.h"
 #include "3dmath.h"
-#include "rand_r.H"
+#include "rand_r.h"
 
 static PlaydateAPI* pd;
 
-static Tracks _tracks;
-
 // game director
-typedef struct {
+typedef struct Timeline {
     size_t len;
     char* timeline;
 } Timeline;
 
-typedef struct {
+typedef struct Section {
     // random placement?
     int random;
     // time in sequence unit
@@ -647,7 +645,7 @@ static Section _test_sections[] = {
 };
 
 
-typedef struct {
+typedef struct SectionCatalog {
     // number of sections
     int n;
     // track sections
@@ -666,40 +664,26 @@ static SectionCatalog _catalog[] = {
     CATALOG_ENTRY(NULL,_test_sections)
 };
 
-struct {
-    int min_cooldown;
-    int max_cooldown;
-    // current cooldown value
-    int cooldown;
-    // next
-    int next_cooldown;
-    // cooldown value (to compute ratio)
-    int total_cooldown;
-    // current timeline cursor
-    int t;
-    // seq count
-    int seq;
-    // current timeline length
-    size_t max_len;
-    Timeline* lanes[MAX_TIMELINES];
-    SectionCatalog catalog;
-    Section* active_section;
-    Section* next_section;
-} _section_director;
-
-static void reset_track_timers(TrackTimers *timers, int is_main)
+// random roll for given track (keyed by current slice & track slot)
+static float track_randf(const TrackDirector* director, const Track* track, const int purpose)
+{
+  return randf_at(director->r_seed, director->slice_id, (int)(track - director->tracks.tracks), purpose);
+}
+
+static void reset_track_timers(TrackDirector* director, Track *track, int is_main)
 {
-  timers->ttl = 12 + (int)(8.f * randf_seeded());
+  TrackTimers *timers = &track->timers;
+  timers->ttl = 12 + (int)(8.f * track_randf(director, track, RAND_TRACK_TTL));
   // make sure coins are not spawned at start
-  timers->trick_ttl = is_main?60 + (int)(15.f * randf_seeded()): 8 + (int)(4.f * randf_seeded());
-  timers->trick_type = randf_seeded() > 0.5f;
+  timers->trick_ttl = is_main?60 + (int)(15.f * track_randf(director, track, RAND_TRACK_TRICK_TTL)): 8 + (int)(4.f * track_randf(director, track, RAND_TRACK_TRICK_TTL));
+  timers->trick_type = track_randf(director, track, RAND_TRACK_TRICK_TYPE) > 0.5f;
 }
 
-static Track *add_track(const float x, const float u, int is_main)
+static Track *add_track(TrackDirector* director, const float x, const float u, int is_main)
 {
-  Track *new_track = &_tracks.tracks[_tracks.n++];
+  Track *new_track = &director->tracks.tracks[director->tracks.n++];
 
-  reset_track_timers(&new_track->timers, is_main); 
+  reset_track_timers(director, new_track, is_main); 
 
   // default values
   new_track->age = 0;
@@ -713,104 +697,105 @@ static Track *add_track(const float x, const float u, int is_main)
   return new_track;
 }
 
-static Section* pick_next_section() {
+static Section* pick_next_section(TrackDirector* director) {
     // any "forced" start section?
-    if (_section_director.seq == 0 && _section_director.catalog.start) {
-        _section_director.seq++;
-        return _section_director.catalog.start;
+    if (director->seq == 0 && director->catalog->start) {
+        director->seq++;
+        return director->catalog->start;
     }
 
     Section* sections[64] = {NULL};
     int n = 0;
     // pick section
-    const int seq = _section_director.seq;
-    for (int i = 0; i < _section_director.catalog.n && i<64; i++) {
-        Section* s = &_section_director.catalog.sections[i];
+    const int seq = director->seq;
+    for (int i = 0; i < director->catalog->n && i<64; i++) {
+        Section* s = &director->catalog->sections[i];
         if (seq >= s->seq.min && seq <= s->seq.max ) {
             sections[n++] = s;
         }
     }
-    _section_director.seq++;
+    director->seq++;
 
     if (!n) {
-        pd->system->error("No active section to pick @%i", _section_director.seq);
+        pd->system->error("No active section to pick @%i", director->seq);
         return NULL;
     }
 
-    return sections[randi_seeded(n)];
+    // note: 2 sections can be picked on the same slice (keyed by sequence)
+    return sections[randi_at(n, director->r_seed, director->slice_id, seq, RAND_SECTION)];
 }
 
-static int update_track(Track *track)
+static int update_track(TrackDirector* director, Track *track)
 {
   if (track->is_dead)
     return 0;
 
   if (track->is_main) {
       // next section?
-      if (!_section_director.active_section) {
+      if (!director->active_section) {
           // lerp width
-          const int w0 = _section_director.active_section ? _section_director.active_section->width : 4;
-          const int w1 = _section_director.next_section ? _section_director.next_section->width : 4;
-          track->width = lerpi(w0, w1, (float)(_section_director.total_cooldown - _section_director.cooldown) / _section_director.total_cooldown);
+          const int w0 = director->active_section ? director->active_section->width : 4;
+          const int w1 = director->next_section ? director->next_section->width : 4;
+          track->width = lerpi(w0, w1, (float)(director->total_cooldown - director->cooldown) / director->total_cooldown);
 
-          _section_director.cooldown--;
+          director->cooldown--;
 
-          if (_section_director.cooldown < 0) {
+          if (director->cooldown < 0) {
               // pick a random section (handle init case) 
-              _section_director.active_section = _section_director.next_section ? _section_director.next_section : pick_next_section();
-              _section_director.next_section = pick_next_section();
+              director->active_section = director->next_section ? director->next_section : pick_next_section(director);
+              director->next_section = pick_next_section(director);
 
               // no available section?
-              if (_section_director.active_section) {
-                  _section_director.t = 0;
-                  Section* s = _section_director.active_section;
+              if (director->active_section) {
+                  director->t = 0;
+                  Section* s = director->active_section;
                   // pick random lanes
                   int lanes[] = { 0,1,2,3,4,5,6,7 };
                   if (s->random)
-                      shuffle_seeded(lanes, s->width); // shuffle only within the effective timelines (eg. no "blanks")
-                  memset(_section_director.lanes, 0, sizeof(Timeline*) * MAX_TIMELINES);
+                      shuffle_at(lanes, s->width, director->r_seed, director->slice_id, RAND_SECTION_LANES); // shuffle only within the effective timelines (eg. no "blanks")
+                  memset(director->lanes, 0, sizeof(Timeline*) * MAX_TIMELINES);
                   int j = 0;
                   size_t max_len = 0;
                   while (s->timelines[j].timeline) {
                       Timeline* timeline = &s->timelines[j];
-                      _section_director.lanes[lanes[j]] = timeline;
+                      director->lanes[lanes[j]] = timeline;
                       if (timeline->len > max_len) max_len = timeline->len;
                       j++;
                   }
-                  _section_director.max_len = max_len;
+                  director->max_len = max_len;
               }
           }
       }
 
-      if (_section_director.active_section) {
-          track->width = _section_director.active_section->width;
+      if (director->active_section) {
+          track->width = director->active_section->width;
 
-          memset(_tracks.pattern, ' ', GROUND_WIDTH);
-          if (_section_director.t < _section_director.max_len) {
+          memset(director->tracks.pattern, ' ', GROUND_WIDTH);
+          if (director->t < director->max_len) {
               const int ii = (int)(track->x / GROUND_CELL_SIZE);
               track->imin = ii - track->width / 2;
               track->imax = ii + track->width / 2;
 
-              int t = _section_director.t;
+              int t = director->t;
               for (int i = 0; i < MAX_TIMELINES; ++i) {
-                  Timeline* timeline = _section_director.lanes[i];
+                  Timeline* timeline = director->lanes[i];
                   // active?
                   if (timeline) {
-                      _tracks.pattern[track->imin + i] = timeline->timeline[t % timeline->len];
+                      director->tracks.pattern[track->imin + i] = timeline->timeline[t % timeline->len];
                   }
               }
-              _section_director.t++;
+              director->t++;
 
               // don't twist sections!
               return 1;
           }
           else {
-              _section_director.active_section = NULL;
-              _section_director.cooldown = _section_director.next_cooldown;
+              director->active_section = NULL;
+              director->cooldown = director->next_cooldown;
 
               // select next section
-              _section_director.total_cooldown = lerpi(_section_director.min_cooldown, _section_director.max_cooldown, randf_seeded());
-              _section_director.next_cooldown = _section_director.total_cooldown;
+              director->total_cooldown = lerpi(director->min_cooldown, director->max_cooldown, randf_at(director->r_seed, director->slice_id, 0, RAND_SECTION_COOLDOWN));
+              director->next_cooldown = director->total_cooldown;
           }
       }
   }
@@ -834,29 +819,29 @@ static int update_track(Track *track)
     if (track->timers.trick_ttl < -5)
     {
       track->h = 0;
-      track->timers.ttl = 4 + (int)(2.f * randf_seeded());
+      track->timers.ttl = 4 + (int)(2.f * track_randf(director, track, RAND_TRACK_TTL));
     }
   }
   if (track->timers.ttl < 0)
   {
     // reset
-    reset_track_timers(&track->timers, 0);
-    track->u = _tracks.twist * (1.6f * randf_seeded() - 0.8f);
+    reset_track_timers(director, track, 0);
+    track->u = director->tracks.twist * (1.6f * track_randf(director, track, RAND_TRACK_TWIST) - 0.8f);
     // offshoot?
-    if (_tracks.n < _tracks.max_tracks && randf_seeded() < 0.25f)
+    if (director->tracks.n < director->tracks.max_tracks && track_randf(director, track, RAND_TRACK_SPAWN) < 0.25f)
     {
-        add_track(track->x, -track->u, 0);
+        add_track(director, track->x, -track->u, 0);
     }
   }
   track->x +=track->u;
-  if (track->x < _tracks.xmin)
+  if (track->x < director->tracks.xmin)
   {
-    track->x = _tracks.xmin;
+    track->x = director->tracks.xmin;
     track->u = -track->u;
   }
-  if (track->x > _tracks.xmax)
+  if (track->x > director->tracks.xmax)
   {
-    track->x = _tracks.xmax;
+    track->x = director->tracks.xmax;
     track->u = -track->u;
   }
 
@@ -870,53 +855,119 @@ static int update_track(Track *track)
 
 // generate ski tracks
 // xmin/xmax: min/max world coordinates for track
-void make_tracks(const int xmin, const int xmax, GroundParams params, Tracks** out)
+void make_tracks(TrackDirector* director, const int xmin, const int xmax, GroundParams params)
 {
-  float angle = 0.25f + 0.45f * randf_seeded();
+  // setup rolls
+  director->r_seed = params.r_seed;
+  director->slice_id = 0;
+  float angle = 0.25f + 0.45f * randf_at(params.r_seed, 0, 0, RAND_TRACK_START);
 
   // set global range
-  _tracks.xmin = xmin;
-  _tracks.xmax = xmax;
-  _tracks.max_tracks = params.num_tracks;
-  _tracks.n = 0;
-  _tracks.twist = params.twist;
-  memset(_tracks.pattern, ' ', GROUND_WIDTH);
-  _tracks.pattern[GROUND_WIDTH] = 0;
+  director->tracks.xmin = xmin;
+  director->tracks.xmax = xmax;
+  director->tracks.max_tracks = params.num_tracks;
+  director->tracks.n = 0;
+  director->tracks.twist = params.twist;
+  memset(director->tracks.pattern, ' ', GROUND_WIDTH);
+  director->tracks.pattern[GROUND_WIDTH] = 0;
 
   // section director
-  _section_director.seq = 0;
-  _section_director.active_section = NULL;
-  _section_director.next_section = NULL;
-  _section_director.min_cooldown = params.min_cooldown;
-  _section_director.max_cooldown = params.max_cooldown;  
+  director->seq = 0;
+  director->t = 0;
+  director->max_len = 0;
+  memset(director->lanes, 0, sizeof(director->lanes));
+  director->active_section = NULL;
+  director->next_section = NULL;
+  // note: first section width ramp
+  director->total_cooldown = 24;
+  director->min_cooldown = params.min_cooldown;
+  director->max_cooldown = params.max_cooldown;  
   // debug safeguards
 #ifdef _DEBUG
   if (params.min_cooldown <= 0 || params.min_cooldown > params.max_cooldown) {
       pd->system->error("Invalid cooldown values: %i/%i", params.min_cooldown, params.max_cooldown);
   }
 #endif 
-  _section_director.cooldown = lerpi(params.min_cooldown, params.max_cooldown, randf_seeded());
-  _section_director.next_cooldown = lerpi(params.min_cooldown, params.max_cooldown, randf_seeded());
-  _section_director.catalog = _catalog[params.track_type];
+  director->cooldown = lerpi(params.min_cooldown, params.max_cooldown, randf_at(params.r_seed, 0, 0, RAND_SECTION_COOLDOWN));
+  director->next_cooldown = lerpi(params.min_cooldown, params.max_cooldown, randf_at(params.r_seed, 0, 1, RAND_SECTION_COOLDOWN));
+  director->track_type = params.track_type;
+  director->catalog = &_catalog[params.track_type];
+
+  add_track(director, lerpf(xmin, xmax, randf_at(params.r_seed, 0, 1, RAND_TRACK_START)), cosf(detauify(angle)), 1);
+}
+
+// section to catalog index
+static int get_section_index(const TrackDirector* director, const Section* s) {
+    const SectionCatalog* catalog = director->catalog;
+    if (!s) return -1;
+    if (s == catalog->start) return catalog->n;
+    return (int)(s - catalog->sections);
+}
 
-  add_track(lerpf(xmin, xmax, randf_seeded()), cosf(detauify(angle)), 1);
+static Section* get_section(const TrackDirector* director, const int i) {
+    const SectionCatalog* catalog = director->catalog;
+    if (i < 0) return NULL;
+    if (i == catalog->n) return catalog->start;
+    return &catalog->sections[i];
+}
 
-  *out = &_tracks;
+void save_tracks(const TrackDirector* director, TracksState* out) {
+    out->tracks = director->tracks;
+    out->r_seed = director->r_seed;
+    out->track_type = director->track_type;
+    out->min_cooldown = director->min_cooldown;
+    out->max_cooldown = director->max_cooldown;
+    out->cooldown = director->cooldown;
+    out->next_cooldown = director->next_cooldown;
+    out->total_cooldown = director->total_cooldown;
+    out->t = director->t;
+    out->seq = director->seq;
+    out->max_len = (int)director->max_len;
+    out->active_section = get_section_index(director, director->active_section);
+    out->next_section = get_section_index(director, director->next_section);
+    const Section* s = director->active_section;
+    for (int i = 0; i < MAX_TIMELINES; i++) {
+        const Timeline* timeline = director->lanes[i];
+        // note: lanes are only valid for active section
+        out->lanes[i] = s && timeline ? (int8_t)(timeline - s->timelines) : -1;
+    }
 }
 
-void update_tracks()
+void restore_tracks(TrackDirector* director, const TracksState* state) {
+    director->tracks = state->tracks;
+    director->r_seed = state->r_seed;
+    director->track_type = state->track_type;
+    director->catalog = &_catalog[state->track_type];
+    director->min_cooldown = state->min_cooldown;
+    director->max_cooldown = state->max_cooldown;
+    director->cooldown = state->cooldown;
+    director->next_cooldown = state->next_cooldown;
+    director->total_cooldown = state->total_cooldown;
+    director->t = state->t;
+    director->seq = state->seq;
+    director->max_len = (size_t)state->max_len;
+    director->active_section = get_section(director, state->active_section);
+    director->next_section = get_section(director, state->next_section);
+    Section* s = director->active_section;
+    for (int i = 0; i < MAX_TIMELINES; i++) {
+        director->lanes[i] = s && state->lanes[i] >= 0 ? &s->timelines[state->lanes[i]] : NULL;
+    }
+}
+
+void update_tracks(TrackDirector* director, const int slice_id)
 {
+  director->slice_id = slice_id;
   int i = 0;
-  while (i < _tracks.n)
+  while (i < director->tracks.n)
   {
-    if (!update_track(&_tracks.tracks[i]))
+    if (!update_track(director, &director->tracks.tracks[i]))
     {
       // shift other tracks down
-      for (int j = i + 1; j < _tracks.n; j++)
+      for (int j = i + 1; j < director->tracks.n; j++)
       {
-        _tracks.tracks[j - 1] = _tracks.tracks[j];
+        director->tracks.tracks[j - 1] = director->tracks.tracks[j];
       }
-      _tracks.n--;
+      director->tracks.n--;
     }
     else
     {
@@ -925,12 +976,12 @@ void update_tracks()
   }
 
   // kill intersections
-  for (int i = 0; i < _tracks.n; i++)
+  for (int i = 0; i < director->tracks.n; i++)
   {
-    Track *s0 = &_tracks.tracks[i];
-    for (int j = i + 1; j < _tracks.n; j++)
+    Track *s0 = &director->tracks.tracks[i];
+    for (int j = i + 1; j < director->tracks.n; j++)
     {
-      Track *s1 = &_tracks.tracks[j];
+      Track *s1 = &director->tracks.tracks[j];
       // don't kill new seeds
       // don't kill is_main track
       if (s1->age > 0 && (int)(s0->x - s1->x) == 0)
@@ -949,11 +1000,11 @@ void update_tracks()
   buffer[0] = '|';
   buffer[31] = '|';  
   buffer[32] = 0;
-  for(int i = 0; i < _tracks.n; i++) {
-      Track* t = &_tracks.tracks[i];
+  for(int i = 0; i < director->tracks.n; i++) {
+      Track* t = &director->tracks.tracks[i];
       buffer[(int)(t->x / 4)] = t->is_main ? '*' : '$';
   }
-  pd->system->logToConsole("%s [%i %i]",buffer,_tracks.xmin,_tracks.xmax);
+  pd->system->logToConsole("%s [%i %i]",buffer,director->tracks.xmin,director->tracks.xmax);
   */  
 }
 
@@ -973,11 +1024,6 @@ static void init_section(Section* s, int i) {
 void tracks_init(PlaydateAPI* playdate) {
     pd = playdate;
 
-    _section_director.active_section = NULL;
-    _section_director.next_section = NULL;
-    _section_director.total_cooldown = 24;    
-    _section_director.cooldown = _section_director.total_cooldown;
-
     // initialize timeline string lenghts
     for (int k = 0; k < sizeof(_catalog) / sizeof(SectionCatalog); ++k) {
         SectionCatalog* catalog = &_catalog[k];
@@ -42,8 +42,65 @@ typedef struct {
   char pattern[GROUND_WIDTH+1];
 } Tracks;
 
-void make_tracks(const int xmin, const int xmax, GroundParams params, Tracks** out);
-void update_tracks();
+struct Timeline;
+struct Section;
+struct SectionCatalog;
+
+// tracks + section director
+typedef struct {
+  Tracks tracks;
+  // course seed
+  int r_seed;
+  // slice being generated (random rolls key, 0: setup)
+  int slice_id;
+  int min_cooldown;
+  int max_cooldown;
+  // current cooldown value
+  int cooldown;
+  // next
+  int next_cooldown;
+  // cooldown value (to compute ratio)
+  int total_cooldown;
+  // current timeline cursor
+  int t;
+  // seq count
+  int seq;
+  // current timeline length
+  size_t max_len;
+  struct Timeline* lanes[MAX_TIMELINES];
+  int track_type;
+  const struct SectionCatalog* catalog;
+  struct Section* active_section;
+  struct Section* next_section;
+} TrackDirector;
+
+// generator state (POD)
+// sections are stored as catalog indices
+typedef struct {
+  Tracks tracks;
+  int r_seed;
+  int track_type;
+  int min_cooldown;
+  int max_cooldown;
+  int cooldown;
+  int next_cooldown;
+  int total_cooldown;
+  int t;
+  int seq;
+  int max_len;
+  // section index (-1: none, catalog size: start section)
+  int active_section;
+  int next_section;
+  // timeline index in active section (-1: none)
+  int8_t lanes[MAX_TIMELINES];
+} TracksState;
+
+void make_tracks(TrackDirector* director, const int xmin, const int xmax, GroundParams params);
+// capture/restore tracks & section director
+void save_tracks(const TrackDirector* director, TracksState* out);
+void restore_tracks(TrackDirector* director, const TracksState* state);
+// slice_id: slice being generated
+void update_tracks(TrackDirector* director, const int slice_id);
 void tracks_init(PlaydateAPI* playdate);
 
 #endif
@@ -0,0 +1,157 @@
+#include <float.h>
+#include "visibility.h"
+
+static PlaydateAPI* pd;
+
+// raycasting angles
+#define RAYCAST_PRECISION 256
+typedef struct {
+    int distance;
+    float angle;
+} Ray;
+static Ray _rays[RAYCAST_PRECISION] = {0};
+
+// view wedge half angle (same as outermost ray)
+static float _wedge_half_angle;
+// distance to wedge far corners (in tiles)
+static float _wedge_radius;
+// conservative margin (in tiles)
+#define WEDGE_EPSILON (1.f / 16.f)
+
+// 24:8 ray length per tile
+// note: clamped on (nearly) axis-aligned rays (way beyond ray length)
+#define RAY_MAX_STEP (1 << 24)
+static int ray_step(const float u) {
+    if (u > 1.f / (1 << 16) || u < -1.f / (1 << 16)) return (int)((1 << 8) / u);
+    return u < 0.f ? -RAY_MAX_STEP : RAY_MAX_STEP;
+}
+
+void collect_tiles_raycast(uint32_t visible_tiles[GROUND_HEIGHT], const Point3d pos, float base_angle) {
+    float x = pos.x / GROUND_CELL_SIZE, y = pos.z / GROUND_CELL_SIZE;
+    int x0 = (int)x, y0 = (int)y;
+
+    // current tile is always in
+    visible_tiles[y0] |= 1 << x0;
+
+    for (int i = 0; i < RAYCAST_PRECISION; ++i) {
+        float angle = base_angle + _rays[i].angle;
+        float v = cosf(angle), u = sinf(angle);
+
+        int mapx = x0, mapy = y0;
+        int mapdx = 1, mapdy = 1;
+        // convert to fixed 24:8
+        int ddx = ray_step(u), ddy = ray_step(v);
+        int distx = 0, disty = 0;
+        if (u < 0.f) {
+            mapdx = -1;
+            ddx = -ddx;
+            distx = (x - mapx) * ddx;
+        }
+        else {
+            distx = (mapx + 1 - x) * ddx;
+        }
+        if (v < 0) {
+            mapdy = -1;
+            ddy = -ddy;
+            disty = (y - mapy) * ddy;
+        }
+        else {
+            disty = (mapy + 1 - y) * ddy;
+        }
+
+        const int dist_max = _rays[i].distance;
+        // 64 bits to avoid overflow on axis-aligned rays
+        while((int64_t)distx * distx + (int64_t)disty * disty < dist_max) {
+            if (distx < disty) {
+                distx += ddx;
+                mapx += mapdx;
+            }
+            else {
+                disty += ddy;
+                mapy += mapdy;
+            }
+            // out of range?
+            if (mapx&~(GROUND_WIDTH-1) || mapy<0 || mapy >= GROUND_HEIGHT) break;
+
+            visible_tiles[mapy] |= 1 << mapx;
+        }
+    }
+}
+
+// x extent of segment a-b within [z0,z1]
+static void clip_edge(const float ax, const float az, const float bx, const float bz, const float z0, const float z1, float* xmin, float* xmax) {
+    if (az == bz) return;
+    for (int k = 0; k < 2; k++) {
+        const float z = k ? z1 : z0;
+        if ((az - z) * (bz - z) <= 0.f) {
+            const float x = ax + (z - az) * (bx - ax) / (bz - az);
+            if (x < *xmin) *xmin = x;
+            if (x > *xmax) *xmax = x;
+        }
+    }
+}
+
+void collect_tiles_wedge(uint32_t visible_tiles[GROUND_HEIGHT], const Point3d pos, float base_angle) {
+    // wedge corners (tile units)
+    float x[3], z[3];
+    x[0] = pos.x / GROUND_CELL_SIZE;
+    z[0] = pos.z / GROUND_CELL_SIZE;
+    x[1] = x[0] + _wedge_radius * sinf(base_angle - _wedge_half_angle);
+    z[1] = z[0] + _wedge_radius * cosf(base_angle - _wedge_half_angle);
+    x[2] = x[0] + _wedge_radius * sinf(base_angle + _wedge_half_angle);
+    z[2] = z[0] + _wedge_radius * cosf(base_angle + _wedge_half_angle);
+
+    float zmin = z[0], zmax = z[0];
+    for (int k = 1; k < 3; k++) {
+        if (z[k] < zmin) zmin = z[k];
+        if (z[k] > zmax) zmax = z[k];
+    }
+    int j0 = (int)floorf(zmin - WEDGE_EPSILON), j1 = (int)floorf(zmax + WEDGE_EPSILON);
+    if (j0 < 0) j0 = 0;
+    if (j1 > GROUND_HEIGHT - 1) j1 = GROUND_HEIGHT - 1;
+
+    for (int j = j0; j <= j1; j++) {
+        // row strip
+        const float z0 = j - WEDGE_EPSILON, z1 = j + 1 + WEDGE_EPSILON;
+        float xmin = FLT_MAX, xmax = -FLT_MAX;
+        for (int k = 0; k < 3; k++) {
+            if (z[k] >= z0 && z[k] <= z1) {
+                if (x[k] < xmin) xmin = x[k];
+                if (x[k] > xmax) xmax = x[k];
+            }
+        }
+        clip_edge(x[0], z[0], x[1], z[1], z0, z1, &xmin, &xmax);
+        clip_edge(x[1], z[1], x[2], z[2], z0, z1, &xmin, &xmax);
+        clip_edge(x[2], z[2], x[0], z[0], z0, z1, &xmin, &xmax);
+        if (xmin > xmax) continue;
+
+        int i0 = (int)floorf(xmin - WEDGE_EPSILON), i1 = (int)floorf(xmax + WEDGE_EPSILON);
+        if (i0 < 0) i0 = 0;
+        if (i1 > GROUND_WIDTH - 1) i1 = GROUND_WIDTH - 1;
+        if (i0 > i1) continue;
+
+        // bits [i0,i1]
+        visible_tiles[j] |= (uint32_t)((2u << i1) - (1u << i0));
+    }
+}
+
+void visibility_init(PlaydateAPI* playdate) {
+    pd = playdate;
+
+    // raycasting angles
+    for(int i=0;i<RAYCAST_PRECISION;++i) {
+        // 1.5f to overshoot 
+        float t = 1.5f * (((float)i) / RAYCAST_PRECISION - 0.5f);
+        const float angle = atan2f(MAX_TILE_DIST, MAX_TILE_DIST * t * 2.f) - PI / 2.f;
+        // using a 24:8 "fixed" value
+        const int dist_max = (int)((MAX_TILE_DIST << 8) / cosf(angle));
+        _rays[i] = (Ray){
+            .distance = dist_max * dist_max,
+            .angle = angle
+        };            
+    }
+
+    // outermost ray
+    _wedge_half_angle = fabsf(_rays[0].angle);
+    _wedge_radius = MAX_TILE_DIST / cosf(_wedge_half_angle);
+}
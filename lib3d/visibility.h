@@ -0,0 +1,22 @@
+#ifndef _visibility_h
+#define _visibility_h
+
+#include <pd_api.h>
+#include "3dmath.h"
+#include "ground_limits.h"
+
+// visible ground tiles (view wedge vs. ground grid)
+// visible tiles are encoded as 1 bit per cell (bit i of row j)
+// base_angle: camera heading (radians)
+
+// ray casting (RAYCAST_PRECISION rays)
+void collect_tiles_raycast(uint32_t visible_tiles[GROUND_HEIGHT], const Point3d pos, float base_angle);
+
+// conservative scan conversion of the view wedge (superset of ray casting)
+// note: ~50% more tiles than ray casting, mostly beyond Z_FAR (faces culled after transform)
+void collect_tiles_wedge(uint32_t visible_tiles[GROUND_HEIGHT], const Point3d pos, float base_angle);
+
+// init module
+void visibility_init(PlaydateAPI* playdate);
+
+#endif
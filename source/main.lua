@@ -453,6 +453,11 @@ function make_plyr(p,on_trick)
 			local flip = _save_state.flip_crank and -1 or 1
 			da = flip * acceleratedChange
 		end
+		-- record (quantized) inputs
+		if _save_state.record_inputs then
+			local held = playdate.buttonIsPressed(_input.action.id)
+			da = lib3d.record_input(da, held and 1 or 0)
+		end
 		-- inverted controls?
 		if self.invert_ttl>0 then
 			da = -da
@@ -944,7 +949,6 @@ function loading_state()
 		end
 
 		next_state(menu_state)
-		--next_state(bench_state)
 		--next_state(vec3_test)
 	end)
 
@@ -1925,40 +1929,6 @@ function make_command_handlers(custom)
 	},{__index=custom or {}})
 end
 
--- -------------------------
--- bench mode
-function bench_state()
-	_ground = make_ground({slope=2,twist=4,num_tracks=1,tight_mode=0,props_rate=0.87,track_type=0,min_cooldown=8,max_cooldown=12})
-	print("ground ok")
-	local pos=vec3(15.5*4,-16,12.5*4)
-	print("new pos")
-	local newy,newn=_ground:find_face(pos)
-	print("location: "..newy)
-	pos[2]=newy+1	
-	local cam=make_cam()
-	print("cam ok")
-	local u=vec3(0,0.9,1)
-	v_normz(u)
-	print("normz ok")
-	cam:track(pos,0,u,1,1)
-	
-	for j=0,3 do
-		local s=""
-		for i=0,3 do
-			s=s.." "..cam.m[j*4+i+1]
-		end
-		print(s)
-	end
-
-	return 
-		-- update
-		function() end,
-		-- draw
-		function()
-			_ground:draw(cam)
-		end
-end
-
 function vec3_test()
 	local vecs={}
 	return
@@ -2026,6 +1996,9 @@ function play_state(params,help_ttl)
 		_save_state.coins+=c
 	end
 	_plyr.hp = params.hp
+	if _save_state.record_inputs then
+		lib3d.start_recording(params.hp, params.min_boost or 0, params.max_boost or 0, params.boost_t or 0)
+	end
 		
 	-- create cam (or grab from caller)
 	local cam=params.cam or make_cam()
@@ -2197,6 +2170,10 @@ function play_state(params,help_ttl)
 					screen:shake()
 
 					if _music then _music:stop() _music=nil end
+					-- keep inputs of last run
+					if _save_state.record_inputs then
+						lib3d.save_recording("last_run.mwr")
+					end
 					-- latest score
 					next_state(stop_sounds_state,plyr_death_state,cam,pos,flr(_plyr.distance),total_tricks,params)
 					-- not active
@@ -2708,6 +2685,8 @@ function _init()
 		_save_state.version = 1
 		_save_state.coins = 0
 		_save_state.flip_crank = false
+		-- debug: record inputs & save last run (last_run.mwr)
+		_save_state.record_inputs = false
 		_save_state.best_1 = 1000
 		_save_state.best_2 = 500
 		_save_state.best_3 = 250